@@ -0,0 +1,152 @@
+#pragma once
+
+#include "router.h"
+#include "dijkstra_router.h"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Маршрутизатор без предрасчёта: двунаправленный A* с нижней оценкой расстояния между вершинами.
+    // Оценка lower_bound(u, v) не должна превышать вес кратчайшего пути из u в v и должна быть согласованной:
+    // lower_bound(u, t) <= weight(u, v) + lower_bound(v, t) для каждого ребра (u, v).
+    // Оба направления используют средний потенциал p(v) = (lower_bound(v, to) - lower_bound(from, v)) / 2,
+    // поэтому поиск продвигается к цели и останавливается, как только сумма минимальных ключей направлений
+    // не меньше найденного пути. Одновременные запросы из разных потоков получают разные рабочие буферы.
+    template <typename Weight>
+    class AStarRouter final : public BaseRouter<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename BaseRouter<Weight>::RouteInfo;
+        using LowerBound = std::function<Weight(VertexId from, VertexId to)>;
+
+        AStarRouter(const Graph& graph, LowerBound lower_bound);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    private:
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        LowerBound lower_bound_;
+
+        // Входящие рёбра вершин в формате CSR для обратного поиска
+        std::vector<size_t> incoming_offsets_;
+        std::vector<EdgeId> incoming_edges_;
+
+        mutable detail::BufferPool<detail::BidirectionalSearchSpace<Weight>> search_spaces_;
+    };
+
+    template <typename Weight>
+    AStarRouter<Weight>::AStarRouter(const Graph& graph, LowerBound lower_bound)
+            : graph_(graph)
+            , lower_bound_(std::move(lower_bound))
+            , incoming_offsets_(graph.GetVertexCount() + 1, 0)
+            , incoming_edges_(graph.GetEdgeCount())
+            , search_spaces_(graph.GetVertexCount())
+    {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            ++incoming_offsets_[edge.to + 1];
+        }
+        std::partial_sum(incoming_offsets_.begin(), incoming_offsets_.end(), incoming_offsets_.begin());
+        std::vector<size_t> positions(incoming_offsets_.begin(), incoming_offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            incoming_edges_[positions[graph.GetEdge(edge_id).to]++] = edge_id;
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename AStarRouter<Weight>::RouteInfo> AStarRouter<Weight>::BuildRoute(VertexId from,
+                                                                                           VertexId to) const {
+        if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex is out of graph");
+        }
+        auto potential = [this, from, to](VertexId vertex) {
+            return (lower_bound_(vertex, to) - lower_bound_(from, vertex)) / 2;
+        };
+        const auto spaces = search_spaces_.Acquire();
+        auto& forward_space = spaces->forward;
+        auto& backward_space = spaces->backward;
+        forward_space.Clear();
+        backward_space.Clear();
+        forward_space.Start(from, potential(from));
+        backward_space.Start(to, -potential(to));
+
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+        if (from == to) {
+            best_weight = ZERO_WEIGHT;
+        }
+        while (forward_space.HasNext() && backward_space.HasNext()) {
+            const Weight forward_key = forward_space.Top().key;
+            const Weight backward_key = backward_space.Top().key;
+            // С согласованным потенциалом путь короче найденного должен пройти через вершины с ключами
+            // меньше минимальных в обеих кучах, поэтому дальнейший поиск его не улучшит
+            if (best_weight && !(forward_key + backward_key < *best_weight)) {
+                break;
+            }
+            const bool forward = !(backward_key < forward_key);
+            auto& space = forward ? forward_space : backward_space;
+            const auto& other = forward ? backward_space : forward_space;
+            const auto current = space.Pop();
+
+            auto relax = [&](EdgeId edge_id, VertexId next) {
+                const Weight weight = current.weight + graph_.GetEdge(edge_id).weight;
+                const Weight next_potential = potential(next);
+                if (!space.Relax(next, weight, edge_id, forward ? weight + next_potential : weight - next_potential)) {
+                    return;
+                }
+                if (other.IsReached(next)) {
+                    const Weight candidate = weight + other.GetWeight(next);
+                    if (!best_weight || candidate < *best_weight) {
+                        best_weight = candidate;
+                        meeting_vertex = next;
+                    }
+                }
+            };
+            if (forward) {
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(current.vertex)) {
+                    relax(edge_id, graph_.GetEdge(edge_id).to);
+                }
+            } else {
+                for (size_t i = incoming_offsets_[current.vertex]; i < incoming_offsets_[current.vertex + 1]; ++i) {
+                    relax(incoming_edges_[i], graph_.GetEdge(incoming_edges_[i]).from);
+                }
+            }
+        }
+
+        if (!best_weight) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = meeting_vertex; vertex != from; ) {
+            const EdgeId edge_id = forward_space.GetPrevEdge(vertex);
+            edges.push_back(edge_id);
+            vertex = graph_.GetEdge(edge_id).from;
+        }
+        std::reverse(edges.begin(), edges.end());
+        for (VertexId vertex = meeting_vertex; vertex != to; ) {
+            const EdgeId edge_id = backward_space.GetPrevEdge(vertex);
+            edges.push_back(edge_id);
+            vertex = graph_.GetEdge(edge_id).to;
+        }
+        // Вес пересчитывается вдоль пути, чтобы порядок сложения совпадал с однонаправленным поиском
+        Weight weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id : edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+        return RouteInfo{weight, std::move(edges)};
+    }
+
+}  // namespace graph
@@ -0,0 +1,436 @@
+#pragma once
+
+#include "router.h"
+#include "dijkstra_router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Маршрутизатор на основе иерархии сжатия (contraction hierarchies).
+    // Предрасчёт упорядочивает вершины по "важности" и последовательно исключает их из графа,
+    // добавляя рёбра-сокращения там, где без них пропал бы кратчайший путь.
+    // Запрос выполняется двунаправленным поиском только по рёбрам, ведущим вверх по иерархии.
+    // Одновременные запросы из разных потоков получают разные рабочие буферы.
+    template <typename Weight>
+    class ContractionHierarchyRouter final : public BaseRouter<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename BaseRouter<Weight>::RouteInfo;
+
+        // Ребро-сокращение, составленное из двух рёбер иерархии
+        struct Shortcut {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId first;
+            EdgeId second;
+        };
+
+        // Результат предрасчёта: ранги вершин и сокращения. Номер i-го сокращения
+        // в иерархии равен graph.GetEdgeCount() + i
+        struct Hierarchy {
+            std::vector<size_t> ranks;
+            std::vector<Shortcut> shortcuts;
+        };
+
+        explicit ContractionHierarchyRouter(const Graph& graph);
+        // Восстановление ранее построенной иерархии без повторного сжатия
+        ContractionHierarchyRouter(const Graph& graph, const Hierarchy& hierarchy);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+        Hierarchy GetHierarchy() const;
+
+    private:
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+        static constexpr size_t WITNESS_SETTLE_LIMIT = 200; // ограничение поиска свидетелей при сжатии
+
+        // Ребро иерархии: первые GetEdgeCount() рёбер совпадают с рёбрами исходного графа,
+        // остальные - сокращения
+        struct HierarchyEdge {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId first = NO_EDGE;
+            EdgeId second = NO_EDGE;
+        };
+
+        // Подготовка иерархии
+        void ContractVertices();
+        std::vector<Shortcut> FindShortcuts(VertexId vertex, size_t settle_limit);
+        void RunWitnessSearch(VertexId from, VertexId excluded, Weight limit, size_t settle_limit);
+        int ComputePriority(VertexId vertex);
+        void BuildSearchGraph();
+
+        // Выполнение запроса
+        void SearchStep(detail::SearchSpace<Weight>& space, const detail::SearchSpace<Weight>& other,
+                        const std::vector<size_t>& offsets, const std::vector<EdgeId>& edges, bool forward,
+                        std::optional<Weight>& best_weight, VertexId& meeting_vertex) const;
+        void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& result) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        std::vector<HierarchyEdge> edges_;
+        std::vector<size_t> ranks_;
+
+        // Рабочие данные сжатия, освобождаются после построения иерархии
+        std::vector<std::vector<EdgeId>> outgoing_;
+        std::vector<std::vector<EdgeId>> incoming_;
+        std::vector<bool> contracted_;
+        std::vector<int> contracted_neighbours_;
+        detail::SearchSpace<Weight> witness_space_;
+
+        // Граф поиска в формате CSR: рёбра вверх по иерархии для прямого поиска
+        // и рёбра сверху вниз (по входящим) для обратного
+        std::vector<size_t> up_offsets_;
+        std::vector<EdgeId> up_edges_;
+        std::vector<size_t> down_offsets_;
+        std::vector<EdgeId> down_edges_;
+
+        mutable detail::BufferPool<detail::BidirectionalSearchSpace<Weight>> search_spaces_;
+    };
+
+    template <typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+            : graph_(graph)
+            , ranks_(graph.GetVertexCount(), 0)
+            , outgoing_(graph.GetVertexCount())
+            , incoming_(graph.GetVertexCount())
+            , contracted_(graph.GetVertexCount(), false)
+            , contracted_neighbours_(graph.GetVertexCount(), 0)
+            , witness_space_(graph.GetVertexCount())
+            , search_spaces_(graph.GetVertexCount())
+    {
+        edges_.reserve(graph.GetEdgeCount());
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            edges_.push_back({edge.from, edge.to, edge.weight});
+            if (edge.from != edge.to) {
+                outgoing_[edge.from].push_back(edge_id);
+                incoming_[edge.to].push_back(edge_id);
+            }
+        }
+        ContractVertices();
+        BuildSearchGraph();
+    }
+
+    template <typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph, const Hierarchy& hierarchy)
+            : graph_(graph)
+            , ranks_(hierarchy.ranks)
+            , witness_space_(0)
+            , search_spaces_(graph.GetVertexCount())
+    {
+        if (ranks_.size() != graph.GetVertexCount()) {
+            throw std::invalid_argument("Hierarchy doesn't match the graph");
+        }
+        edges_.reserve(graph.GetEdgeCount() + hierarchy.shortcuts.size());
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            edges_.push_back({edge.from, edge.to, edge.weight});
+        }
+        for (const auto& shortcut : hierarchy.shortcuts) {
+            if (shortcut.first >= edges_.size() || shortcut.second >= edges_.size()
+                || shortcut.from >= ranks_.size() || shortcut.to >= ranks_.size()) {
+                throw std::invalid_argument("Hierarchy doesn't match the graph");
+            }
+            edges_.push_back({shortcut.from, shortcut.to, shortcut.weight, shortcut.first, shortcut.second});
+        }
+        BuildSearchGraph();
+    }
+
+    template <typename Weight>
+    typename ContractionHierarchyRouter<Weight>::Hierarchy ContractionHierarchyRouter<Weight>::GetHierarchy() const {
+        Hierarchy hierarchy{ranks_, {}};
+        hierarchy.shortcuts.reserve(edges_.size() - graph_.GetEdgeCount());
+        for (EdgeId edge_id = graph_.GetEdgeCount(); edge_id < edges_.size(); ++edge_id) {
+            const auto& edge = edges_[edge_id];
+            hierarchy.shortcuts.push_back({edge.from, edge.to, edge.weight, edge.first, edge.second});
+        }
+        return hierarchy;
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::RunWitnessSearch(VertexId from, VertexId excluded, Weight limit,
+                                                               size_t settle_limit) {
+        // Поиск свидетелей - обычная Дейкстра в оставшемся графе без сжимаемой вершины,
+        // обрезанная по весу и по числу обработанных вершин. Обрезка делает предрасчёт
+        // быстрее ценой лишних (но корректных) сокращений
+        auto& space = witness_space_;
+        space.Clear();
+        space.Start(from);
+        size_t settled = 0;
+        while (space.HasNext() && settled < settle_limit) {
+            const auto current = space.Pop();
+            if (limit < current.weight) {
+                break;
+            }
+            ++settled;
+            for (const EdgeId edge_id : outgoing_[current.vertex]) {
+                const auto& edge = edges_[edge_id];
+                if (edge.to != excluded && !contracted_[edge.to]) {
+                    space.Relax(edge.to, current.weight + edge.weight, edge_id);
+                }
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::vector<typename ContractionHierarchyRouter<Weight>::Shortcut>
+    ContractionHierarchyRouter<Weight>::FindShortcuts(VertexId vertex, size_t settle_limit) {
+        // Из параллельных рёбер с соседями оставляем самые лёгкие
+        std::unordered_map<VertexId, EdgeId> best_incoming;
+        for (const EdgeId edge_id : incoming_[vertex]) {
+            const auto& edge = edges_[edge_id];
+            if (contracted_[edge.from]) {
+                continue;
+            }
+            auto [it, inserted] = best_incoming.emplace(edge.from, edge_id);
+            if (!inserted && edge.weight < edges_[it->second].weight) {
+                it->second = edge_id;
+            }
+        }
+        std::unordered_map<VertexId, EdgeId> best_outgoing;
+        for (const EdgeId edge_id : outgoing_[vertex]) {
+            const auto& edge = edges_[edge_id];
+            if (contracted_[edge.to]) {
+                continue;
+            }
+            auto [it, inserted] = best_outgoing.emplace(edge.to, edge_id);
+            if (!inserted && edge.weight < edges_[it->second].weight) {
+                it->second = edge_id;
+            }
+        }
+
+        std::vector<Shortcut> shortcuts;
+        if (best_outgoing.empty()) {
+            return shortcuts;
+        }
+        Weight max_out_weight = ZERO_WEIGHT;
+        for (const auto& [to, out_edge] : best_outgoing) {
+            max_out_weight = std::max(max_out_weight, edges_[out_edge].weight);
+        }
+        for (const auto& [from, in_edge] : best_incoming) {
+            // Один поиск свидетелей из соседа покрывает сразу все исходящие рёбра вершины
+            RunWitnessSearch(from, vertex, edges_[in_edge].weight + max_out_weight, settle_limit);
+            for (const auto& [to, out_edge] : best_outgoing) {
+                if (from == to) {
+                    continue;
+                }
+                const Weight via_weight = edges_[in_edge].weight + edges_[out_edge].weight;
+                if (!witness_space_.IsReached(to) || via_weight < witness_space_.GetWeight(to)) {
+                    shortcuts.push_back({from, to, via_weight, in_edge, out_edge});
+                }
+            }
+        }
+        return shortcuts;
+    }
+
+    template <typename Weight>
+    int ContractionHierarchyRouter<Weight>::ComputePriority(VertexId vertex) {
+        // Разность рёбер (сколько сокращений добавится минус сколько рёбер исчезнет)
+        // плюс число уже сжатых соседей, чтобы сжатие шло по графу равномерно
+        int removed_edges = 0;
+        for (const EdgeId edge_id : incoming_[vertex]) {
+            removed_edges += contracted_[edges_[edge_id].from] ? 0 : 1;
+        }
+        for (const EdgeId edge_id : outgoing_[vertex]) {
+            removed_edges += contracted_[edges_[edge_id].to] ? 0 : 1;
+        }
+        const int added_edges = static_cast<int>(FindShortcuts(vertex, WITNESS_SETTLE_LIMIT / 10).size());
+        return added_edges - removed_edges + contracted_neighbours_[vertex];
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::ContractVertices() {
+        using QueueItem = std::pair<int, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        const size_t vertex_count = graph_.GetVertexCount();
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            queue.push({ComputePriority(vertex), vertex});
+        }
+
+        size_t rank = 0;
+        while (!queue.empty()) {
+            const VertexId vertex = queue.top().second;
+            queue.pop();
+            if (contracted_[vertex]) {
+                continue;
+            }
+            // Ленивое обновление: приоритет пересчитывается при извлечении,
+            // и если вершина перестала быть лучшей, она возвращается в очередь
+            const int priority = ComputePriority(vertex);
+            if (!queue.empty() && priority > queue.top().first) {
+                queue.push({priority, vertex});
+                continue;
+            }
+
+            for (const auto& shortcut : FindShortcuts(vertex, WITNESS_SETTLE_LIMIT)) {
+                const EdgeId edge_id = edges_.size();
+                edges_.push_back({shortcut.from, shortcut.to, shortcut.weight, shortcut.first, shortcut.second});
+                outgoing_[shortcut.from].push_back(edge_id);
+                incoming_[shortcut.to].push_back(edge_id);
+            }
+            for (const EdgeId edge_id : incoming_[vertex]) {
+                ++contracted_neighbours_[edges_[edge_id].from];
+            }
+            for (const EdgeId edge_id : outgoing_[vertex]) {
+                ++contracted_neighbours_[edges_[edge_id].to];
+            }
+            contracted_[vertex] = true;
+            ranks_[vertex] = rank++;
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::BuildSearchGraph() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        up_offsets_.assign(vertex_count + 1, 0);
+        down_offsets_.assign(vertex_count + 1, 0);
+        for (const auto& edge : edges_) {
+            if (edge.from == edge.to) {
+                continue;
+            }
+            if (ranks_[edge.from] < ranks_[edge.to]) {
+                ++up_offsets_[edge.from + 1];
+            } else {
+                ++down_offsets_[edge.to + 1];
+            }
+        }
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+            up_offsets_[vertex + 1] += up_offsets_[vertex];
+            down_offsets_[vertex + 1] += down_offsets_[vertex];
+        }
+        up_edges_.resize(up_offsets_.back());
+        down_edges_.resize(down_offsets_.back());
+        std::vector<size_t> up_positions(up_offsets_.begin(), up_offsets_.end() - 1);
+        std::vector<size_t> down_positions(down_offsets_.begin(), down_offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+            const auto& edge = edges_[edge_id];
+            if (edge.from == edge.to) {
+                continue;
+            }
+            if (ranks_[edge.from] < ranks_[edge.to]) {
+                up_edges_[up_positions[edge.from]++] = edge_id;
+            } else {
+                down_edges_[down_positions[edge.to]++] = edge_id;
+            }
+        }
+
+        outgoing_ = {};
+        incoming_ = {};
+        contracted_ = {};
+        contracted_neighbours_ = {};
+        witness_space_ = detail::SearchSpace<Weight>(0);
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::SearchStep(detail::SearchSpace<Weight>& space,
+                                                        const detail::SearchSpace<Weight>& other,
+                                                        const std::vector<size_t>& offsets,
+                                                        const std::vector<EdgeId>& edges, bool forward,
+                                                        std::optional<Weight>& best_weight,
+                                                        VertexId& meeting_vertex) const {
+        const auto current = space.Pop();
+        if (other.IsReached(current.vertex)) {
+            const Weight candidate = current.weight + other.GetWeight(current.vertex);
+            if (!best_weight || candidate < *best_weight) {
+                best_weight = candidate;
+                meeting_vertex = current.vertex;
+            }
+        }
+        for (size_t i = offsets[current.vertex]; i < offsets[current.vertex + 1]; ++i) {
+            const auto& edge = edges_[edges[i]];
+            space.Relax(forward ? edge.to : edge.from, current.weight + edge.weight, edges[i]);
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& result) const {
+        std::vector<EdgeId> stack{edge_id};
+        while (!stack.empty()) {
+            const EdgeId current = stack.back();
+            stack.pop_back();
+            const auto& edge = edges_[current];
+            if (edge.first == NO_EDGE) {
+                result.push_back(current);
+            } else {
+                stack.push_back(edge.second);
+                stack.push_back(edge.first);
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+    ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex is out of graph");
+        }
+        const auto spaces = search_spaces_.Acquire();
+        auto& forward_space = spaces->forward;
+        auto& backward_space = spaces->backward;
+        forward_space.Clear();
+        backward_space.Clear();
+        forward_space.Start(from);
+        backward_space.Start(to);
+
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+        // Каждое направление останавливается, когда его минимальный вес не меньше найденного пути
+        auto is_active = [&best_weight](detail::SearchSpace<Weight>& space) {
+            return space.HasNext() && (!best_weight || space.Top().weight < *best_weight);
+        };
+        while (true) {
+            const bool forward_active = is_active(forward_space);
+            const bool backward_active = is_active(backward_space);
+            if (!forward_active && !backward_active) {
+                break;
+            }
+            if (forward_active && (!backward_active || !(backward_space.Top().weight < forward_space.Top().weight))) {
+                SearchStep(forward_space, backward_space, up_offsets_, up_edges_, true, best_weight, meeting_vertex);
+            } else {
+                SearchStep(backward_space, forward_space, down_offsets_, down_edges_, false, best_weight,
+                           meeting_vertex);
+            }
+        }
+
+        if (!best_weight) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> hierarchy_edges;
+        for (VertexId vertex = meeting_vertex; vertex != from; ) {
+            const EdgeId edge_id = forward_space.GetPrevEdge(vertex);
+            hierarchy_edges.push_back(edge_id);
+            vertex = edges_[edge_id].from;
+        }
+        std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+        for (VertexId vertex = meeting_vertex; vertex != to; ) {
+            const EdgeId edge_id = backward_space.GetPrevEdge(vertex);
+            hierarchy_edges.push_back(edge_id);
+            vertex = edges_[edge_id].to;
+        }
+
+        std::vector<EdgeId> edges;
+        for (const EdgeId edge_id : hierarchy_edges) {
+            UnpackEdge(edge_id, edges);
+        }
+        return RouteInfo{*best_weight, std::move(edges)};
+    }
+
+}  // namespace graph
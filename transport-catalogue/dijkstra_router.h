@@ -0,0 +1,330 @@
+#pragma once
+
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Матрица весов кратчайших путей: строка на каждый источник, столбец на каждую цель.
+    // std::nullopt, если цель недостижима
+    template <typename Weight>
+    using WeightMatrix = std::vector<std::vector<std::optional<Weight>>>;
+
+    namespace detail {
+        // Рабочие буферы одного направления поиска по Дейкстре: веса, входящие рёбра и двоичная куча.
+        // Метки поколений позволяют начинать новый поиск без очистки массивов размера O(V).
+        template <typename Weight>
+        class SearchSpace {
+        public:
+            struct QueueItem {
+                Weight key; // приоритет в куче (вес пути, либо вес плюс потенциал)
+                Weight weight;
+                VertexId vertex;
+
+                bool operator>(const QueueItem& other) const {
+                    return key > other.key;
+                }
+            };
+
+            explicit SearchSpace(size_t vertex_count)
+                    : weights_(vertex_count)
+                    , prev_edges_(vertex_count)
+                    , visit_marks_(vertex_count, 0) {
+            }
+
+            void Clear() {
+                if (++current_mark_ == 0) {
+                    std::fill(visit_marks_.begin(), visit_marks_.end(), 0);
+                    current_mark_ = 1;
+                }
+                heap_.clear();
+            }
+
+            bool IsReached(VertexId vertex) const {
+                return visit_marks_[vertex] == current_mark_;
+            }
+
+            Weight GetWeight(VertexId vertex) const {
+                return weights_[vertex];
+            }
+
+            // Ребро, по которому поиск пришёл в вершину; для стартовой вершины не определено
+            EdgeId GetPrevEdge(VertexId vertex) const {
+                return prev_edges_[vertex];
+            }
+
+            void Start(VertexId vertex, Weight key = {}) {
+                visit_marks_[vertex] = current_mark_;
+                weights_[vertex] = Weight{};
+                heap_.push_back({key, Weight{}, vertex});
+            }
+
+            // Возвращает true, если вес вершины улучшился
+            bool Relax(VertexId vertex, Weight weight, EdgeId prev_edge, Weight key) {
+                if (IsReached(vertex) && !(weight < weights_[vertex])) {
+                    return false;
+                }
+                visit_marks_[vertex] = current_mark_;
+                weights_[vertex] = weight;
+                prev_edges_[vertex] = prev_edge;
+                heap_.push_back({key, weight, vertex});
+                std::push_heap(heap_.begin(), heap_.end(), std::greater<QueueItem>{});
+                return true;
+            }
+
+            bool Relax(VertexId vertex, Weight weight, EdgeId prev_edge) {
+                return Relax(vertex, weight, prev_edge, weight);
+            }
+
+            // Проверяет, остались ли в куче актуальные записи, попутно выбрасывая устаревшие
+            bool HasNext() {
+                while (!heap_.empty() && weights_[heap_.front().vertex] < heap_.front().weight) {
+                    std::pop_heap(heap_.begin(), heap_.end(), std::greater<QueueItem>{});
+                    heap_.pop_back();
+                }
+                return !heap_.empty();
+            }
+
+            // Вызывать только после HasNext() == true
+            const QueueItem& Top() const {
+                return heap_.front();
+            }
+
+            QueueItem Pop() {
+                std::pop_heap(heap_.begin(), heap_.end(), std::greater<QueueItem>{});
+                const QueueItem item = heap_.back();
+                heap_.pop_back();
+                return item;
+            }
+
+        private:
+            std::vector<Weight> weights_;
+            std::vector<EdgeId> prev_edges_;
+            std::vector<uint32_t> visit_marks_;
+            uint32_t current_mark_ = 0;
+            std::vector<QueueItem> heap_;
+        };
+
+        // Буферы двунаправленного поиска
+        template <typename Weight>
+        struct BidirectionalSearchSpace {
+            explicit BidirectionalSearchSpace(size_t vertex_count)
+                    : forward(vertex_count)
+                    , backward(vertex_count) {
+            }
+
+            SearchSpace<Weight> forward;
+            SearchSpace<Weight> backward;
+        };
+
+        // Рабочие буферы маршрутизатора для одновременных запросов: запрос берёт свободный набор буферов
+        // (или создаёт новый) и возвращает его по завершении. Мьютекс держится только на время взятия
+        // и возврата, поэтому запросы из разных потоков не ждут друг друга, а буферы переиспользуются
+        template <typename Buffers>
+        class BufferPool {
+        public:
+            // Набор буферов, взятый на время запроса
+            class Lease {
+            public:
+                Lease(BufferPool& pool, std::unique_ptr<Buffers> buffers)
+                        : pool_(pool)
+                        , buffers_(std::move(buffers)) {
+                }
+                Lease(const Lease&) = delete;
+                Lease& operator=(const Lease&) = delete;
+                ~Lease() {
+                    pool_.Release(std::move(buffers_));
+                }
+
+                Buffers& operator*() const {
+                    return *buffers_;
+                }
+                Buffers* operator->() const {
+                    return buffers_.get();
+                }
+
+            private:
+                BufferPool& pool_;
+                std::unique_ptr<Buffers> buffers_;
+            };
+
+            explicit BufferPool(size_t vertex_count)
+                    : vertex_count_(vertex_count) {
+            }
+
+            Lease Acquire() {
+                {
+                    std::lock_guard guard(mutex_);
+                    if (!free_.empty()) {
+                        std::unique_ptr<Buffers> buffers = std::move(free_.back());
+                        free_.pop_back();
+                        return Lease(*this, std::move(buffers));
+                    }
+                }
+                return Lease(*this, std::make_unique<Buffers>(vertex_count_));
+            }
+
+        private:
+            void Release(std::unique_ptr<Buffers> buffers) {
+                std::lock_guard guard(mutex_);
+                free_.push_back(std::move(buffers));
+            }
+
+            size_t vertex_count_;
+            std::mutex mutex_;
+            std::vector<std::unique_ptr<Buffers>> free_;
+        };
+    }  // namespace detail
+
+    // Маршрутизатор без предрасчёта: на каждый запрос запускается алгоритм Дейкстры
+    // на двоичной куче. Подготовка линейна по размеру графа, а рабочие буферы
+    // переиспользуются между запросами; одновременные запросы из разных потоков получают разные буферы.
+    template <typename Weight>
+    class DijkstraRouter final : public BaseRouter<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename BaseRouter<Weight>::RouteInfo;
+        using EdgeWeight = std::function<Weight(EdgeId)>;
+
+        explicit DijkstraRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+        // Поиск с весами рёбер, вычисляемыми во время запроса вместо весов графа.
+        // Веса должны быть неотрицательными
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const EdgeWeight& edge_weight) const;
+
+        // Матрица "многие ко многим": один поиск на источник, который останавливается, как только
+        // достигнуты все цели; пути не восстанавливаются. Источники обходятся последовательно в одном
+        // взятом из пула наборе буферов: одновременные запросы и так выполняются в разных потоках
+        WeightMatrix<Weight> ComputeWeightMatrix(const std::vector<VertexId>& sources,
+                                                 const std::vector<VertexId>& targets) const;
+
+    private:
+        template <typename EdgeWeightGetter>
+        std::optional<RouteInfo> Search(VertexId from, VertexId to, EdgeWeightGetter get_weight) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        mutable detail::BufferPool<detail::SearchSpace<Weight>> search_spaces_;
+    };
+
+    template <typename Weight>
+    DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+            : graph_(graph)
+            , search_spaces_(graph.GetVertexCount())
+    {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                                 VertexId to) const {
+        return Search(from, to, [this](EdgeId edge_id) {
+            return graph_.GetEdge(edge_id).weight;
+        });
+    }
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+    DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to, const EdgeWeight& edge_weight) const {
+        return Search(from, to, edge_weight);
+    }
+
+    template <typename Weight>
+    template <typename EdgeWeightGetter>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+    DijkstraRouter<Weight>::Search(VertexId from, VertexId to, EdgeWeightGetter get_weight) const {
+        if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex is out of graph");
+        }
+        const auto lease = search_spaces_.Acquire();
+        auto& space = *lease;
+        space.Clear();
+        space.Start(from);
+
+        while (space.HasNext()) {
+            const auto current = space.Pop();
+            if (current.vertex == to) {
+                break;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(current.vertex)) {
+                space.Relax(graph_.GetEdge(edge_id).to, current.weight + get_weight(edge_id), edge_id);
+            }
+        }
+
+        if (!space.IsReached(to)) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdge(space.GetPrevEdge(vertex)).from) {
+            edges.push_back(space.GetPrevEdge(vertex));
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{space.GetWeight(to), std::move(edges)};
+    }
+
+    template <typename Weight>
+    WeightMatrix<Weight> DijkstraRouter<Weight>::ComputeWeightMatrix(const std::vector<VertexId>& sources,
+                                                                     const std::vector<VertexId>& targets) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        std::vector<bool> is_target(vertex_count, false);
+        size_t target_count = 0;
+        for (const VertexId vertex : sources) {
+            if (vertex >= vertex_count) {
+                throw std::out_of_range("Vertex is out of graph");
+            }
+        }
+        for (const VertexId vertex : targets) {
+            if (vertex >= vertex_count) {
+                throw std::out_of_range("Vertex is out of graph");
+            }
+            if (!is_target[vertex]) {
+                is_target[vertex] = true;
+                ++target_count;
+            }
+        }
+
+        WeightMatrix<Weight> result(sources.size());
+        const auto lease = search_spaces_.Acquire();
+        auto& space = *lease;
+        for (size_t source_id = 0; source_id < sources.size(); ++source_id) {
+            space.Clear();
+            space.Start(sources[source_id]);
+            size_t settled_targets = 0;
+            while (settled_targets < target_count && space.HasNext()) {
+                const auto current = space.Pop();
+                if (is_target[current.vertex]) {
+                    ++settled_targets;
+                }
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(current.vertex)) {
+                    const auto& edge = graph_.GetEdge(edge_id);
+                    space.Relax(edge.to, current.weight + edge.weight, edge_id);
+                }
+            }
+            auto& row = result[source_id];
+            row.reserve(targets.size());
+            for (const VertexId target : targets) {
+                row.push_back(space.IsReached(target) ? std::optional<Weight>(space.GetWeight(target))
+                                                      : std::nullopt);
+            }
+        }
+        return result;
+    }
+
+}  // namespace graph
@@ -1,18 +1,26 @@
 #pragma once
 #include "geo.h"
+#include "ranges.h"
 
+#include <cstdint>
 #include <vector>
 #include <string>
-#include <unordered_set>
+#include <string_view>
+
+// Плотные номера остановок и маршрутов: назначаются каталогом по порядку добавления, начиная с нуля
+using StopId = uint32_t;
+using BusId = uint32_t;
 
 struct Stop {
-    std::string name; // Название остановки
+    std::string_view name; // Название остановки (в каталоге - в его хранилище названий)
     geo::Coordinates coordinates; // Координаты
+    StopId id = 0; // Номер остановки в каталоге
 };
 struct Bus {
-    std::string name; // Название маршрута
-    std::vector<const Stop*> stops; // Остановки на маршруте
+    std::string_view name; // Название маршрута (в каталоге - в его хранилище названий)
+    std::vector<StopId> stops; // Номера остановок на маршруте
     bool is_round_route; // Проверка маршрута на кольцевой тип
+    BusId id = 0; // Номер маршрута в каталоге
 };
 
 struct BusInfo {
@@ -22,6 +30,12 @@ struct BusInfo {
     double curvature = 0.0; // Коэффициент извилистости
 };
 
+struct NearbyStop {
+    std::string_view name; // Название остановки
+    double distance = 0.0; // Расстояние до точки запроса в метрах
+};
+
 struct StopInfo {
-    std::unordered_set<std::string_view> buses; // Список маршрутов, проходящих через остановку
+    // Маршруты, проходящие через остановку, упорядоченные по названию (без копирования из индекса каталога)
+    ranges::Range<std::vector<std::string_view>::const_iterator> buses;
 };
\ No newline at end of file
@@ -1,7 +1,296 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GEO_X86_SIMD
+#include <immintrin.h>
+#endif
+
 namespace geo{
+    namespace {
+        const double EARTH_RADIUS = 6371000.;
+        const double DR = M_PI / 180.;
+
+        // Равнопромежуточная проекция: cos((a + b) / 2) = sqrt((1 + cos(a + b)) / 2), так как |(a + b) / 2| <= 90
+        double ComputeEquirectangularDistance(double sin_lat_a, double cos_lat_a, double lat_a, double lng_a,
+                                              double sin_lat_b, double cos_lat_b, double lat_b, double lng_b) {
+            const double cos_lat_sum = cos_lat_a * cos_lat_b - sin_lat_a * sin_lat_b;
+            const double cos_mean_lat = std::sqrt(std::max(0., (1. + cos_lat_sum) / 2.));
+            double delta_lng = std::abs(lng_a - lng_b);
+            if (delta_lng > 180.) {
+                delta_lng = 360. - delta_lng;
+            }
+            const double x = delta_lng * DR * cos_mean_lat;
+            const double y = (lat_a - lat_b) * DR;
+            return std::sqrt(x * x + y * y) * EARTH_RADIUS;
+        }
+
+        void ComputeEquirectangularDistances(const PreparedPoints& points, const uint32_t* from, const uint32_t* to,
+                                             size_t count, double* result) {
+            for (size_t i = 0; i < count; ++i) {
+                const uint32_t a = from[i];
+                const uint32_t b = to[i];
+                result[i] = ComputeEquirectangularDistance(points.sin_lat[a], points.cos_lat[a], points.lat[a],
+                                                           points.lng[a], points.sin_lat[b], points.cos_lat[b],
+                                                           points.lat[b], points.lng[b]);
+            }
+        }
+
+        void ComputeDistancesScalar(const PreparedPoints& points, const uint32_t* from, const uint32_t* to,
+                                    size_t begin, size_t count, double* result) {
+            for (size_t i = begin; i < count; ++i) {
+                const uint32_t a = from[i];
+                const uint32_t b = to[i];
+                if (points.lat[a] == points.lat[b] && points.lng[a] == points.lng[b]) {
+                    result[i] = 0.;
+                    continue;
+                }
+                const double cos_angle = points.sin_lat[a] * points.sin_lat[b]
+                                         + points.cos_lat[a] * points.cos_lat[b]
+                                           * std::cos(std::abs(points.lng[a] - points.lng[b]) * DR);
+                result[i] = std::acos(std::clamp(cos_angle, -1., 1.)) * EARTH_RADIUS;
+            }
+        }
+
+#ifdef GEO_X86_SIMD
+        // Векторные косинус и арккосинус по алгоритмам fdlibm: приведение аргумента к [-pi/4, pi/4] с точностью
+        // двух слагаемых pi/2, минимаксные многочлены для sin/cos, рациональное приближение для acos
+        namespace coefficients {
+            const double TWO_OVER_PI = 6.36619772367581382433e-01;
+            const double PIO2_1 = 1.57079632673412561417e+00;
+            const double PIO2_1T = 6.07710050650619224932e-11;
+            const double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03,
+                         S3 = -1.98412698298579493134e-04, S4 = 2.75573137070700676789e-06,
+                         S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+            const double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03,
+                         C3 = 2.48015872894767294178e-05, C4 = -2.75573143513906633035e-07,
+                         C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+            const double PIO2_HI = 1.57079632679489655800e+00, PIO2_LO = 6.12323399573676603587e-17,
+                         PI = 3.14159265358979311600e+00;
+            const double PS0 = 1.66666666666666657415e-01, PS1 = -3.25565818622400915405e-01,
+                         PS2 = 2.01212532134862925881e-01, PS3 = -4.00555345006794114027e-02,
+                         PS4 = 7.91534994289814532176e-04, PS5 = 3.47933107596021167570e-05;
+            const double QS1 = -2.40339491173441421878e+00, QS2 = 2.02094576023350569471e+00,
+                         QS3 = -6.88283971605453293030e-01, QS4 = 7.70381505559019352791e-02;
+            // Сложение с этим числом округляет до целого значения с |x| < 2^51
+            const double ROUND_MAGIC = 6755399441055744.;
+        }
+
+#define GEO_TARGET_AVX2 __attribute__((target("avx2")))
+#define GEO_TARGET_SSE2 __attribute__((target("sse2")))
+
+        // ____________________ AVX2: четыре расстояния за итерацию
+
+        GEO_TARGET_AVX2 inline __m256d Set4(double value) {
+            return _mm256_set1_pd(value);
+        }
+
+        // Четыре значения по индексам. Сборка с маской и нулевым источником: у _mm256_i32gather_pd
+        // источник не инициализирован, и GCC выдаёт -Wmaybe-uninitialized
+        GEO_TARGET_AVX2 inline __m256d Gather4(const double* values, __m128i indexes) {
+            const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), values, indexes, all, 8);
+        }
+
+        GEO_TARGET_AVX2 inline __m256d Poly4(__m256d z, std::initializer_list<double> coeffs) {
+            auto it = coeffs.end();
+            __m256d result = Set4(*--it);
+            while (it != coeffs.begin()) {
+                result = _mm256_add_pd(_mm256_mul_pd(result, z), Set4(*--it));
+            }
+            return result;
+        }
+
+        // cos(x) для x >= 0
+        GEO_TARGET_AVX2 __m256d Cos4(__m256d x) {
+            using namespace coefficients;
+            const __m256d k = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(x, Set4(TWO_OVER_PI)), Set4(ROUND_MAGIC)),
+                                            Set4(ROUND_MAGIC));
+            const __m256d r = _mm256_sub_pd(_mm256_sub_pd(x, _mm256_mul_pd(k, Set4(PIO2_1))),
+                                            _mm256_mul_pd(k, Set4(PIO2_1T)));
+            const __m256d z = _mm256_mul_pd(r, r);
+            // sin(r) = r + r^3 * S(z)
+            const __m256d sin_r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(z, r), Poly4(z, {S1, S2, S3, S4, S5, S6})));
+            // cos(r) = w + (((1 - w) - z/2) + z^2 * C(z)), w = 1 - z/2
+            const __m256d hz = _mm256_mul_pd(z, Set4(0.5));
+            const __m256d w = _mm256_sub_pd(Set4(1.), hz);
+            const __m256d cos_r = _mm256_add_pd(w, _mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(Set4(1.), w), hz),
+                    _mm256_mul_pd(_mm256_mul_pd(z, z), Poly4(z, {C1, C2, C3, C4, C5, C6}))));
+            // Четверть окружности: cos(x) = cos r, -sin r, -cos r, sin r
+            const __m256i quadrant = _mm256_and_si256(_mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(k)), _mm256_set1_epi64x(3));
+            const __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+                    _mm256_and_si256(quadrant, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(1)));
+            const __m256d negate = _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+                    _mm256_and_si256(_mm256_add_epi64(quadrant, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(2)),
+                    _mm256_set1_epi64x(2)));
+            const __m256d result = _mm256_blendv_pd(cos_r, sin_r, swap);
+            return _mm256_xor_pd(result, _mm256_and_pd(negate, Set4(-0.)));
+        }
+
+        // acos(x) для x из [-1, 1]
+        GEO_TARGET_AVX2 __m256d Acos4(__m256d x) {
+            using namespace coefficients;
+            const __m256d abs_x = _mm256_andnot_pd(Set4(-0.), x);
+            const __m256d is_small = _mm256_cmp_pd(abs_x, Set4(0.5), _CMP_LT_OQ);
+            const __m256d is_negative = _mm256_cmp_pd(x, Set4(0.), _CMP_LT_OQ);
+            const __m256d z = _mm256_blendv_pd(_mm256_mul_pd(_mm256_sub_pd(Set4(1.), abs_x), Set4(0.5)),
+                                               _mm256_mul_pd(x, x), is_small);
+            const __m256d p = _mm256_mul_pd(z, Poly4(z, {PS0, PS1, PS2, PS3, PS4, PS5}));
+            const __m256d q = Poly4(z, {1., QS1, QS2, QS3, QS4});
+            const __m256d r = _mm256_div_pd(p, q);
+            // |x| < 0.5: pi/2 - (x - (pio2_lo - x * r))
+            const __m256d small = _mm256_sub_pd(Set4(PIO2_HI),
+                    _mm256_sub_pd(x, _mm256_sub_pd(Set4(PIO2_LO), _mm256_mul_pd(x, r))));
+            const __m256d s = _mm256_sqrt_pd(z);
+            // x <= -0.5: pi - 2 * (s + (r * s - pio2_lo))
+            const __m256d negative = _mm256_sub_pd(Set4(PI), _mm256_mul_pd(Set4(2.),
+                    _mm256_add_pd(s, _mm256_sub_pd(_mm256_mul_pd(r, s), Set4(PIO2_LO)))));
+            // x >= 0.5: 2 * (df + (r * s + c)), df - s с обнулёнными младшими битами, c = (z - df^2) / (s + df)
+            const __m256d df = _mm256_and_pd(s, _mm256_castsi256_pd(_mm256_set1_epi64x(
+                    static_cast<long long>(0xFFFFFFFF00000000ULL))));
+            const __m256d c = _mm256_div_pd(_mm256_sub_pd(z, _mm256_mul_pd(df, df)), _mm256_add_pd(s, df));
+            const __m256d positive = _mm256_mul_pd(Set4(2.), _mm256_add_pd(df, _mm256_add_pd(_mm256_mul_pd(r, s), c)));
+            // При x = 1 выражение для c не определено (0 / 0), а результат - ноль
+            const __m256d is_one = _mm256_cmp_pd(x, Set4(1.), _CMP_GE_OQ);
+            return _mm256_andnot_pd(is_one, _mm256_blendv_pd(_mm256_blendv_pd(positive, negative, is_negative),
+                                                             small, is_small));
+        }
+
+        GEO_TARGET_AVX2 void ComputeDistancesAvx2(const PreparedPoints& points, const uint32_t* from,
+                                                  const uint32_t* to, size_t count, double* result) {
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to + i));
+                const __m256d lat_a = Gather4(points.lat.data(), a);
+                const __m256d lat_b = Gather4(points.lat.data(), b);
+                const __m256d lng_a = Gather4(points.lng.data(), a);
+                const __m256d lng_b = Gather4(points.lng.data(), b);
+                const __m256d same = _mm256_and_pd(_mm256_cmp_pd(lat_a, lat_b, _CMP_EQ_OQ),
+                                                   _mm256_cmp_pd(lng_a, lng_b, _CMP_EQ_OQ));
+                const __m256d delta = _mm256_mul_pd(_mm256_andnot_pd(Set4(-0.), _mm256_sub_pd(lng_a, lng_b)), Set4(DR));
+                __m256d cos_angle = _mm256_add_pd(
+                        _mm256_mul_pd(Gather4(points.sin_lat.data(), a),
+                                      Gather4(points.sin_lat.data(), b)),
+                        _mm256_mul_pd(_mm256_mul_pd(Gather4(points.cos_lat.data(), a),
+                                                    Gather4(points.cos_lat.data(), b)),
+                                      Cos4(delta)));
+                cos_angle = _mm256_max_pd(_mm256_min_pd(cos_angle, Set4(1.)), Set4(-1.));
+                const __m256d distance = _mm256_mul_pd(Acos4(cos_angle), Set4(EARTH_RADIUS));
+                _mm256_storeu_pd(result + i, _mm256_andnot_pd(same, distance));
+            }
+            ComputeDistancesScalar(points, from, to, i, count, result);
+        }
+
+        // ____________________ SSE2: два расстояния за итерацию
+
+        GEO_TARGET_SSE2 inline __m128d Set2(double value) {
+            return _mm_set1_pd(value);
+        }
+
+        GEO_TARGET_SSE2 inline __m128d Blend2(__m128d if_false, __m128d if_true, __m128d mask) {
+            return _mm_or_pd(_mm_and_pd(mask, if_true), _mm_andnot_pd(mask, if_false));
+        }
+
+        GEO_TARGET_SSE2 inline __m128d Poly2(__m128d z, std::initializer_list<double> coeffs) {
+            auto it = coeffs.end();
+            __m128d result = Set2(*--it);
+            while (it != coeffs.begin()) {
+                result = _mm_add_pd(_mm_mul_pd(result, z), Set2(*--it));
+            }
+            return result;
+        }
+
+        GEO_TARGET_SSE2 __m128d Cos2(__m128d x) {
+            using namespace coefficients;
+            const __m128d k = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(x, Set2(TWO_OVER_PI)), Set2(ROUND_MAGIC)),
+                                         Set2(ROUND_MAGIC));
+            const __m128d r = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(k, Set2(PIO2_1))), _mm_mul_pd(k, Set2(PIO2_1T)));
+            const __m128d z = _mm_mul_pd(r, r);
+            const __m128d sin_r = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(z, r), Poly2(z, {S1, S2, S3, S4, S5, S6})));
+            const __m128d hz = _mm_mul_pd(z, Set2(0.5));
+            const __m128d w = _mm_sub_pd(Set2(1.), hz);
+            const __m128d cos_r = _mm_add_pd(w, _mm_add_pd(_mm_sub_pd(_mm_sub_pd(Set2(1.), w), hz),
+                    _mm_mul_pd(_mm_mul_pd(z, z), Poly2(z, {C1, C2, C3, C4, C5, C6}))));
+            // Номера четвертей в младших 32 битах, расширяются до 64-битных масок
+            const __m128i quadrant = _mm_and_si128(_mm_cvttpd_epi32(k), _mm_set1_epi32(3));
+            const __m128i swap_bits = _mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1));
+            const __m128i negate_bits = _mm_cmpeq_epi32(
+                    _mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), _mm_set1_epi32(2));
+            const __m128d swap = _mm_castsi128_pd(_mm_unpacklo_epi32(swap_bits, swap_bits));
+            const __m128d negate = _mm_castsi128_pd(_mm_unpacklo_epi32(negate_bits, negate_bits));
+            return _mm_xor_pd(Blend2(cos_r, sin_r, swap), _mm_and_pd(negate, Set2(-0.)));
+        }
+
+        GEO_TARGET_SSE2 __m128d Acos2(__m128d x) {
+            using namespace coefficients;
+            const __m128d abs_x = _mm_andnot_pd(Set2(-0.), x);
+            const __m128d is_small = _mm_cmplt_pd(abs_x, Set2(0.5));
+            const __m128d is_negative = _mm_cmplt_pd(x, Set2(0.));
+            const __m128d z = Blend2(_mm_mul_pd(_mm_sub_pd(Set2(1.), abs_x), Set2(0.5)), _mm_mul_pd(x, x), is_small);
+            const __m128d p = _mm_mul_pd(z, Poly2(z, {PS0, PS1, PS2, PS3, PS4, PS5}));
+            const __m128d q = Poly2(z, {1., QS1, QS2, QS3, QS4});
+            const __m128d r = _mm_div_pd(p, q);
+            const __m128d small = _mm_sub_pd(Set2(PIO2_HI), _mm_sub_pd(x, _mm_sub_pd(Set2(PIO2_LO), _mm_mul_pd(x, r))));
+            const __m128d s = _mm_sqrt_pd(z);
+            const __m128d negative = _mm_sub_pd(Set2(PI), _mm_mul_pd(Set2(2.),
+                    _mm_add_pd(s, _mm_sub_pd(_mm_mul_pd(r, s), Set2(PIO2_LO)))));
+            const __m128d df = _mm_and_pd(s, _mm_castsi128_pd(_mm_set_epi32(-1, 0, -1, 0)));
+            const __m128d c = _mm_div_pd(_mm_sub_pd(z, _mm_mul_pd(df, df)), _mm_add_pd(s, df));
+            const __m128d positive = _mm_mul_pd(Set2(2.), _mm_add_pd(df, _mm_add_pd(_mm_mul_pd(r, s), c)));
+            const __m128d is_one = _mm_cmpge_pd(x, Set2(1.));
+            return _mm_andnot_pd(is_one, Blend2(Blend2(positive, negative, is_negative), small, is_small));
+        }
+
+        GEO_TARGET_SSE2 void ComputeDistancesSse2(const PreparedPoints& points, const uint32_t* from,
+                                                  const uint32_t* to, size_t count, double* result) {
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                const uint32_t a0 = from[i], a1 = from[i + 1];
+                const uint32_t b0 = to[i], b1 = to[i + 1];
+                const __m128d lat_a = _mm_set_pd(points.lat[a1], points.lat[a0]);
+                const __m128d lat_b = _mm_set_pd(points.lat[b1], points.lat[b0]);
+                const __m128d lng_a = _mm_set_pd(points.lng[a1], points.lng[a0]);
+                const __m128d lng_b = _mm_set_pd(points.lng[b1], points.lng[b0]);
+                const __m128d same = _mm_and_pd(_mm_cmpeq_pd(lat_a, lat_b), _mm_cmpeq_pd(lng_a, lng_b));
+                const __m128d delta = _mm_mul_pd(_mm_andnot_pd(Set2(-0.), _mm_sub_pd(lng_a, lng_b)), Set2(DR));
+                __m128d cos_angle = _mm_add_pd(
+                        _mm_mul_pd(_mm_set_pd(points.sin_lat[a1], points.sin_lat[a0]),
+                                   _mm_set_pd(points.sin_lat[b1], points.sin_lat[b0])),
+                        _mm_mul_pd(_mm_mul_pd(_mm_set_pd(points.cos_lat[a1], points.cos_lat[a0]),
+                                              _mm_set_pd(points.cos_lat[b1], points.cos_lat[b0])),
+                                   Cos2(delta)));
+                cos_angle = _mm_max_pd(_mm_min_pd(cos_angle, Set2(1.)), Set2(-1.));
+                const __m128d distance = _mm_mul_pd(Acos2(cos_angle), Set2(EARTH_RADIUS));
+                _mm_storeu_pd(result + i, _mm_andnot_pd(same, distance));
+            }
+            ComputeDistancesScalar(points, from, to, i, count, result);
+        }
+#endif
+
+        using DistancesKernel = void (*)(const PreparedPoints&, const uint32_t*, const uint32_t*, size_t, double*);
+
+        DistancesKernel SelectDistancesKernel() {
+#ifdef GEO_X86_SIMD
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return ComputeDistancesAvx2;
+            }
+            if (__builtin_cpu_supports("sse2")) {
+                return ComputeDistancesSse2;
+            }
+#endif
+            return [](const PreparedPoints& points, const uint32_t* from, const uint32_t* to, size_t count,
+                      double* result) {
+                ComputeDistancesScalar(points, from, to, 0, count, result);
+            };
+        }
+    }
+
     double ComputeDistance(Coordinates from, Coordinates to) {
         using namespace std;
         if (from == to) {
@@ -12,4 +301,52 @@ namespace geo{
                     + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
                * 6371000;
     }
-}
\ No newline at end of file
+
+    double ComputeDistance(Coordinates from, Coordinates to, DistanceMode mode) {
+        if (mode == DistanceMode::SPHERICAL) {
+            return ComputeDistance(from, to);
+        }
+        return ComputeEquirectangularDistance(std::sin(from.lat * DR), std::cos(from.lat * DR), from.lat, from.lng,
+                                              std::sin(to.lat * DR), std::cos(to.lat * DR), to.lat, to.lng);
+    }
+
+    CompactCoordinates CompactCoordinates::FromCoordinates(Coordinates coordinates) {
+        if (!(std::abs(coordinates.lat) <= 180.) || !(std::abs(coordinates.lng) <= 180.)) {
+            throw std::out_of_range("Coordinates are out of range");
+        }
+        return {static_cast<int32_t>(std::lround(coordinates.lat * SCALE)),
+                static_cast<int32_t>(std::lround(coordinates.lng * SCALE))};
+    }
+
+    Coordinates CompactCoordinates::ToCoordinates() const {
+        return {lat / SCALE, lng / SCALE};
+    }
+
+    void PreparedPoints::Add(Coordinates coordinates) {
+        sin_lat.push_back(std::sin(coordinates.lat * DR));
+        cos_lat.push_back(std::cos(coordinates.lat * DR));
+        lat.push_back(coordinates.lat);
+        lng.push_back(coordinates.lng);
+    }
+
+    void PreparedPoints::Set(size_t index, Coordinates coordinates) {
+        sin_lat.at(index) = std::sin(coordinates.lat * DR);
+        cos_lat[index] = std::cos(coordinates.lat * DR);
+        lat[index] = coordinates.lat;
+        lng[index] = coordinates.lng;
+    }
+
+    size_t PreparedPoints::Size() const {
+        return lat.size();
+    }
+
+    void ComputeDistances(const PreparedPoints& points, const uint32_t* from, const uint32_t* to, size_t count,
+                          double* result, DistanceMode mode) {
+        if (mode == DistanceMode::EQUIRECTANGULAR) {
+            ComputeEquirectangularDistances(points, from, to, count, result);
+            return;
+        }
+        static const DistancesKernel kernel = SelectDistancesKernel();
+        kernel(points, from, to, count, result);
+    }
+}
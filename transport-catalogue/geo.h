@@ -1,6 +1,9 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace geo {
     struct Coordinates {
@@ -14,5 +17,54 @@ namespace geo {
         }
     };
 
+    // Координаты в миллионных долях градуса: вдвое меньше памяти, чем Coordinates.
+    // Округление сдвигает точку не больше чем на 0.5e-6 градуса по каждой оси, то есть не больше 8 см
+    // по поверхности; повторное округление уже округлённых координат их не меняет
+    struct CompactCoordinates {
+        static constexpr double SCALE = 1e6;
+
+        int32_t lat = 0;
+        int32_t lng = 0;
+
+        // Бросает std::out_of_range, если координата больше 180 градусов по модулю
+        static CompactCoordinates FromCoordinates(Coordinates coordinates);
+        Coordinates ToCoordinates() const;
+    };
+
+    // Способ расчёта расстояния по поверхности
+    enum class DistanceMode {
+        // Сферическая теорема косинусов. Для близких точек аргумент арккосинуса близок к 1,
+        // и погрешность округления даёт ошибку порядка 0.1 м независимо от расстояния
+        SPHERICAL,
+        // Локальная равнопромежуточная проекция по средней широте: без тригонометрии на пару точек
+        // в пакетном расчёте. Ошибка относительно сферы растёт как куб расстояния и квадрат тангенса широты:
+        // при широте до 60 градусов - не больше 3 см на 20 км и 0.5 м на 50 км (до 70 градусов - 7 см и 1.1 м).
+        // Подходит для расстояний в пределах города
+        EQUIRECTANGULAR
+    };
+
     double ComputeDistance(Coordinates from, Coordinates to);
-}
\ No newline at end of file
+    double ComputeDistance(Coordinates from, Coordinates to, DistanceMode mode);
+
+    // Точки для пакетного расчёта расстояний: синус и косинус широты считаются один раз при добавлении точки.
+    // Массивы хранятся раздельно и подряд, индекс - номер точки
+    struct PreparedPoints {
+        std::vector<double> sin_lat;
+        std::vector<double> cos_lat;
+        std::vector<double> lat; // градусы
+        std::vector<double> lng; // градусы
+
+        void Add(Coordinates coordinates);
+        void Set(size_t index, Coordinates coordinates); // Замена координат существующей точки
+        size_t Size() const;
+    };
+
+    // Пакетный расчёт: result[i] - расстояние между точками from[i] и to[i] из points, i < count.
+    // Результат совпадает с ComputeDistance с точностью до погрешности округления (аргумент арккосинуса
+    // ограничивается отрезком [-1, 1]). Используются векторные инструкции AVX2 или SSE2, если процессор
+    // их поддерживает (выбор при первом вызове), иначе - скалярный расчёт.
+    // В режиме EQUIRECTANGULAR косинус средней широты получается из сохранённых синусов и косинусов,
+    // поэтому расчёт обходится сложениями, умножениями и двумя квадратными корнями на пару
+    void ComputeDistances(const PreparedPoints& points, const uint32_t* from, const uint32_t* to, size_t count,
+                          double* result, DistanceMode mode = DistanceMode::SPHERICAL);
+}
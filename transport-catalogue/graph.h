@@ -31,6 +31,8 @@ namespace graph {
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+        // Изменение веса ребра без изменения структуры графа
+        void SetEdgeWeight(EdgeId edge_id, Weight weight);
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
     private:
@@ -66,6 +68,11 @@ namespace graph {
         return edges_.at(edge_id);
     }
 
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+        edges_.at(edge_id).weight = weight;
+    }
+
     template <typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
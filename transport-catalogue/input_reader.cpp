@@ -64,12 +64,10 @@ namespace input_reader {
         }
     }
 
-    string GetNameFromRequest(string_view request) {
+    string_view GetNameFromRequest(string_view request) {
         size_t pos1 = request.find(' ') + 1;
         size_t pos2 = request.find(':');
-        string name = string(request.substr(pos1, pos2 - pos1));
-        CutPartOfRequest(request, pos2);
-        return name;
+        return request.substr(pos1, pos2 - pos1);
     }
 
     bool GetRouteType(const string_view& request) {
@@ -102,7 +100,7 @@ namespace input_reader {
                     destination = string(request.substr(0, request.size()));
                 }
                 const Stop* to = catalogue.FindStop(destination);
-                catalogue.SetDistance(from, to, distance);
+                catalogue.SetDistance(from->id, to->id, distance);
                 delimiter = request.find(',');
             }
             auto pos_m = request.find('m');
@@ -110,7 +108,7 @@ namespace input_reader {
             request.remove_prefix(pos_m + 5);
             string destination = string(request.substr(0, request.size()));
             const Stop* to = catalogue.FindStop(destination);
-            catalogue.SetDistance(from, to, distance);
+            catalogue.SetDistance(from->id, to->id, distance);
         }
     }
 
@@ -144,7 +142,7 @@ namespace input_reader {
             }
         }
         for (const auto& stop : bus_stops) {
-            bus.stops.push_back(catalogue.FindStop(stop));
+            bus.stops.push_back(catalogue.FindStop(stop)->id);
         }
         return bus;
     }
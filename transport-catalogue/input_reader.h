@@ -29,7 +29,7 @@ namespace input_reader {
 
     std::string_view GetCommand(const std::string_view& request); //Выделяем тип запроса из строки
     RequestType GetRequestType(const std::string_view& request); //Определяем тип запроса
-    std::string GetNameFromRequest(std::string_view request); //Выделяем название остановки или маршрута из запроса
+    std::string_view GetNameFromRequest(std::string_view request); //Выделяем название остановки или маршрута из запроса
     bool GetRouteType(const std::string_view& request);
 
     void SetDistanceBetweenStops(TransportCatalogue& catalogue, std::string_view rest_request); //Задаем дистанцию между остановками из запроса
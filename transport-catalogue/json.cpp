@@ -1,49 +1,243 @@
 #include "json.h"
 
-#include <iterator>
+#include <charconv>
+#include <cstdio>
+#include <sstream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JSON_X86_SIMD
+#include <immintrin.h>
+#endif
 
 namespace json {
 
     namespace {
         using namespace std::literals;
 
-        Node LoadNode(std::istream& input);
-        Node LoadString(std::istream& input);
+        bool IsSpace(char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+        }
 
-        std::string LoadLiteral(std::istream& input) {
-            std::string s;
-            while (std::isalpha(input.peek())) {
-                s.push_back(static_cast<char>(input.get()));
+        // Символ, на котором останавливается копирование строки: кавычка, обратная косая черта
+        // или управляющий символ (меньше 0x20)
+        bool IsStringSpecial(char c) {
+            return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+        }
+
+        // Сканеры возвращают первую позицию в [pos, end) с нужным символом или end
+        using ScanKernel = const char* (*)(const char* pos, const char* end);
+
+        const char* FindStringSpecialScalar(const char* pos, const char* end) {
+            while (pos != end && !IsStringSpecial(*pos)) {
+                ++pos;
             }
-            return s;
+            return pos;
+        }
+
+        const char* SkipSpacesScalar(const char* pos, const char* end) {
+            while (pos != end && IsSpace(*pos)) {
+                ++pos;
+            }
+            return pos;
+        }
+
+#ifdef JSON_X86_SIMD
+#define JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#define JSON_TARGET_SSE2 __attribute__((target("sse2")))
+
+        // Маски байтов блока: биты кавычек, обратных черт и управляющих символов / пробельных символов.
+        // Управляющий символ: насыщающее вычитание 0x1F даёт ноль только для байтов <= 0x1F.
+        // Пробельные символы: пробел и диапазон 0x09..0x0D (после вычитания 9 - не больше 4 без знака)
+
+        JSON_TARGET_SSE2 inline unsigned StringSpecialMask16(__m128i block) {
+            const __m128i special = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'))),
+                    _mm_cmpeq_epi8(_mm_subs_epu8(block, _mm_set1_epi8(0x1F)), _mm_setzero_si128()));
+            return static_cast<unsigned>(_mm_movemask_epi8(special));
+        }
+
+        JSON_TARGET_SSE2 inline unsigned SpaceMask16(__m128i block) {
+            const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8(9));
+            const __m128i space = _mm_or_si128(
+                    _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                    _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted));
+            return static_cast<unsigned>(_mm_movemask_epi8(space));
+        }
+
+        // ____________________ SSE2: 16 байт за итерацию
+
+        JSON_TARGET_SSE2 const char* FindStringSpecialSse2(const char* pos, const char* end) {
+            for (; end - pos >= 16; pos += 16) {
+                const unsigned mask = StringSpecialMask16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)));
+                if (mask != 0) {
+                    return pos + __builtin_ctz(mask);
+                }
+            }
+            return FindStringSpecialScalar(pos, end);
+        }
+
+        JSON_TARGET_SSE2 const char* SkipSpacesSse2(const char* pos, const char* end) {
+            for (; end - pos >= 16; pos += 16) {
+                const unsigned mask = ~SpaceMask16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) & 0xFFFFu;
+                if (mask != 0) {
+                    return pos + __builtin_ctz(mask);
+                }
+            }
+            return SkipSpacesScalar(pos, end);
+        }
+
+        // ____________________ AVX2: 32 байта за итерацию
+
+        JSON_TARGET_AVX2 const char* FindStringSpecialAvx2(const char* pos, const char* end) {
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i backslash = _mm256_set1_epi8('\\');
+            const __m256i control = _mm256_set1_epi8(0x1F);
+            for (; end - pos >= 32; pos += 32) {
+                const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+                const __m256i special = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)),
+                        _mm256_cmpeq_epi8(_mm256_subs_epu8(block, control), _mm256_setzero_si256()));
+                const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+                if (mask != 0) {
+                    return pos + __builtin_ctz(mask);
+                }
+            }
+            return FindStringSpecialSse2(pos, end);
+        }
+
+        JSON_TARGET_AVX2 const char* SkipSpacesAvx2(const char* pos, const char* end) {
+            const __m256i space_char = _mm256_set1_epi8(' ');
+            const __m256i tab = _mm256_set1_epi8(9);
+            const __m256i range = _mm256_set1_epi8(4);
+            for (; end - pos >= 32; pos += 32) {
+                const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+                const __m256i shifted = _mm256_sub_epi8(block, tab);
+                const __m256i space = _mm256_or_si256(
+                        _mm256_cmpeq_epi8(block, space_char),
+                        _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, range), shifted));
+                const auto mask = ~static_cast<unsigned>(_mm256_movemask_epi8(space));
+                if (mask != 0) {
+                    return pos + __builtin_ctz(mask);
+                }
+            }
+            return SkipSpacesSse2(pos, end);
         }
+#endif
 
-        Node LoadArray(std::istream& input) {
+        struct ScanKernels {
+            ScanKernel find_string_special = FindStringSpecialScalar;
+            ScanKernel skip_spaces = SkipSpacesScalar;
+        };
+
+        // Сканеры выбираются при первом разборе по возможностям процессора
+        const ScanKernels& GetScanKernels() {
+            static const ScanKernels kernels = [] {
+                ScanKernels result;
+#ifdef JSON_X86_SIMD
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2")) {
+                    result = {FindStringSpecialAvx2, SkipSpacesAvx2};
+                } else if (__builtin_cpu_supports("sse2")) {
+                    result = {FindStringSpecialSse2, SkipSpacesSse2};
+                }
+#endif
+                return result;
+            }();
+            return kernels;
+        }
+
+        // Разбор идёт по непрерывному буферу указателем: символы читаются без вызовов потока,
+        // а строки и числа берутся из буфера целыми отрезками
+        struct Cursor {
+            const char* pos;
+            const char* end;
+            const ScanKernels& kernels = GetScanKernels();
+
+            bool AtEnd() const {
+                return pos == end;
+            }
+
+            // Символ в текущей позиции или EOF в конце буфера
+            int Peek() const {
+                return pos != end ? static_cast<unsigned char>(*pos) : EOF;
+            }
+
+            // Следующий символ после пробельных (как operator>> потока); false в конце буфера.
+            // Длинные отступы пропускаются векторным сканером, одиночный пробел - без его вызова
+            bool NextToken(char& c) {
+                if (pos != end && IsSpace(*pos)) {
+                    ++pos;
+                    if (pos != end && IsSpace(*pos)) {
+                        pos = kernels.skip_spaces(pos, end);
+                    }
+                }
+                if (pos == end) {
+                    return false;
+                }
+                c = *pos++;
+                return true;
+            }
+        };
+
+        bool IsDigit(int c) {
+            return c >= '0' && c <= '9';
+        }
+
+        bool IsAlpha(int c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+
+        Node LoadNode(Cursor& input);
+        std::string LoadString(Cursor& input);
+
+        std::string_view LoadLiteral(Cursor& input) {
+            const char* begin = input.pos;
+            while (IsAlpha(input.Peek())) {
+                ++input.pos;
+            }
+            return {begin, static_cast<size_t>(input.pos - begin)};
+        }
+
+        Node LoadArray(Cursor& input) {
             std::vector<Node> result;
 
-            for (char c; input >> c && c != ']';) {
+            char c;
+            bool closed = false;
+            while (input.NextToken(c)) {
+                if (c == ']') {
+                    closed = true;
+                    break;
+                }
                 if (c != ',') {
-                    input.putback(c);
+                    --input.pos;
                 }
                 result.push_back(LoadNode(input));
             }
-            if (!input) {
+            if (!closed) {
                 throw ParsingError("Array parsing error"s);
             }
             return Node(std::move(result));
         }
 
-        Node LoadDict(std::istream& input) {
+        Node LoadDict(Cursor& input) {
             Dict dict;
 
-            for (char c; input >> c && c != '}';) {
+            char c;
+            bool closed = false;
+            while (input.NextToken(c)) {
+                if (c == '}') {
+                    closed = true;
+                    break;
+                }
                 if (c == '"') {
-                    std::string key = LoadString(input).AsString();
-                    if (input >> c && c == ':') {
-                        if (dict.find(key) != dict.end()) {
+                    std::string key = LoadString(input);
+                    if (input.NextToken(c) && c == ':') {
+                        // Ключ ищется один раз: позиция вставки служит подсказкой для emplace_hint
+                        const auto it = dict.lower_bound(key);
+                        if (it != dict.end() && it->first == key) {
                             throw ParsingError("Duplicate key '"s + key + "' have been found");
                         }
-                        dict.emplace(std::move(key), LoadNode(input));
+                        dict.emplace_hint(it, std::move(key), LoadNode(input));
                     } else {
                         throw ParsingError(": is expected but '"s + c + "' has been found"s);
                     }
@@ -51,30 +245,31 @@ namespace json {
                     throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
                 }
             }
-            if (!input) {
+            if (!closed) {
                 throw ParsingError("Dictionary parsing error"s);
             }
             return Node(std::move(dict));
         }
 
-        Node LoadString(std::istream& input) {
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
+        std::string LoadString(Cursor& input) {
             std::string s;
             while (true) {
-                if (it == end) {
+                // Отрезок без кавычек, экранирования и управляющих символов находится векторным сканером
+                // и копируется целиком
+                const char* run = input.pos;
+                input.pos = input.kernels.find_string_special(input.pos, input.end);
+                s.append(run, input.pos);
+                if (input.AtEnd()) {
                     throw ParsingError("String parsing error");
                 }
-                const char ch = *it;
+                const char ch = *input.pos++;
                 if (ch == '"') {
-                    ++it;
                     break;
                 } else if (ch == '\\') {
-                    ++it;
-                    if (it == end) {
+                    if (input.AtEnd()) {
                         throw ParsingError("String parsing error");
                     }
-                    const char escaped_char = *(it);
+                    const char escaped_char = *input.pos++;
                     switch (escaped_char) {
                         case 'n':
                             s.push_back('\n');
@@ -97,60 +292,52 @@ namespace json {
                 } else if (ch == '\n' || ch == '\r') {
                     throw ParsingError("Unexpected end of line"s);
                 } else {
+                    // Остальные управляющие символы допускаются в строке как есть
                     s.push_back(ch);
                 }
-                ++it;
             }
 
-            return Node(std::move(s));
+            return s;
         }
 
-        Node LoadBool(std::istream& input) {
+        Node LoadBool(Cursor& input) {
             const auto s = LoadLiteral(input);
             if (s == "true"sv) {
                 return Node{true};
             } else if (s == "false"sv) {
                 return Node{false};
             } else {
-                throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+                throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
             }
         }
 
-        Node LoadNull(std::istream& input) {
+        Node LoadNull(Cursor& input) {
             if (auto literal = LoadLiteral(input); literal == "null"sv) {
                 return Node{nullptr};
             } else {
-                throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+                throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
             }
         }
 
-        Node LoadNumber(std::istream& input) {
-            std::string parsed_num;
-
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
-                }
-            };
+        Node LoadNumber(Cursor& input) {
+            const char* begin = input.pos;
 
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
+            // Считывает одну или более цифр
+            auto read_digits = [&input] {
+                if (!IsDigit(input.Peek())) {
                     throw ParsingError("A digit is expected"s);
                 }
-                while (std::isdigit(input.peek())) {
-                    read_char();
+                while (IsDigit(input.Peek())) {
+                    ++input.pos;
                 }
             };
 
-            if (input.peek() == '-') {
-                read_char();
+            if (input.Peek() == '-') {
+                ++input.pos;
             }
             // Парсим целую часть числа
-            if (input.peek() == '0') {
-                read_char();
+            if (input.Peek() == '0') {
+                ++input.pos;
                 // После 0 в JSON не могут идти другие цифры
             } else {
                 read_digits();
@@ -158,41 +345,39 @@ namespace json {
 
             bool is_int = true;
             // Парсим дробную часть числа
-            if (input.peek() == '.') {
-                read_char();
+            if (input.Peek() == '.') {
+                ++input.pos;
                 read_digits();
                 is_int = false;
             }
 
             // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
+            if (int ch = input.Peek(); ch == 'e' || ch == 'E') {
+                ++input.pos;
+                if (ch = input.Peek(); ch == '+' || ch == '-') {
+                    ++input.pos;
                 }
                 read_digits();
                 is_int = false;
             }
 
-            try {
-                if (is_int) {
-                    // Сначала пробуем преобразовать строку в int
-                    try {
-                        return std::stoi(parsed_num);
-                    } catch (...) {
-                        // В случае неудачи, например, при переполнении
-                        // код ниже попробует преобразовать строку в double
-                    }
+            if (is_int) {
+                // Сначала пробуем преобразовать строку в int; при переполнении число читается как double
+                int value = 0;
+                if (const auto [ptr, ec] = std::from_chars(begin, input.pos, value); ec == std::errc{}) {
+                    return value;
                 }
-                return std::stod(parsed_num);
-            } catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
             }
+            double value = 0.;
+            if (const auto [ptr, ec] = std::from_chars(begin, input.pos, value); ec != std::errc{}) {
+                throw ParsingError("Failed to convert "s + std::string(begin, input.pos) + " to number"s);
+            }
+            return value;
         }
 
-        Node LoadNode(std::istream& input) {
+        Node LoadNode(Cursor& input) {
             char c;
-            if (!(input >> c)) {
+            if (!input.NextToken(c)) {
                 throw ParsingError("Unexpected EOF"s);
             }
             switch (c) {
@@ -211,13 +396,13 @@ namespace json {
                     // литералов true либо false
                     [[fallthrough]];
                 case 'f':
-                    input.putback(c);
+                    --input.pos;
                     return LoadBool(input);
                 case 'n':
-                    input.putback(c);
+                    --input.pos;
                     return LoadNull(input);
                 default:
-                    input.putback(c);
+                    --input.pos;
                     return LoadNumber(input);
             }
         }
@@ -340,12 +525,220 @@ namespace json {
 
     }  // namespace
 
+    Document Load(std::string_view text) {
+        Cursor cursor{text.data(), text.data() + text.size()};
+        return Document{LoadNode(cursor)};
+    }
+
     Document Load(std::istream& input) {
-        return Document{LoadNode(input)};
+        // Поток читается в буфер целиком: одним вызовом, если известен его размер, иначе - блоками
+        std::string text;
+        const auto start = input.tellg();
+        if (start != std::istream::pos_type(-1) && input.seekg(0, std::ios::end)) {
+            const auto size = input.tellg() - start;
+            input.seekg(start);
+            text.resize(static_cast<size_t>(size));
+            input.read(text.data(), size);
+            text.resize(static_cast<size_t>(input.gcount()));
+        } else {
+            input.clear();
+            std::ostringstream buffer;
+            buffer << input.rdbuf();
+            text = std::move(buffer).str();
+        }
+        return Load(text);
     }
 
     void Print(const Document& doc, std::ostream& output) {
         PrintNode(doc.GetRoot(), PrintContext{output});
     }
 
+    Reader::Reader(std::istream& input)
+        : input_(input) {
+    }
+
+    bool Reader::Fill(size_t& keep) {
+        buffer_.erase(0, keep);
+        pos_ -= keep;
+        keep = 0;
+        const size_t size = buffer_.size();
+        buffer_.resize(size + BLOCK_SIZE);
+        input_.read(buffer_.data() + size, BLOCK_SIZE);
+        buffer_.resize(size + static_cast<size_t>(input_.gcount()));
+        return buffer_.size() > size;
+    }
+
+    int Reader::PeekToken() {
+        while (true) {
+            const char* data = buffer_.data();
+            pos_ = GetScanKernels().skip_spaces(data + pos_, data + buffer_.size()) - data;
+            if (pos_ < buffer_.size()) {
+                return static_cast<unsigned char>(buffer_[pos_]);
+            }
+            size_t keep = pos_;
+            if (!Fill(keep)) {
+                return EOF;
+            }
+        }
+    }
+
+    void Reader::SkipValue(size_t& begin) {
+        // Граница значения ищется без разбора: скобки считаются вне строк, число или литерал
+        // заканчивается на разделителе. Ошибки в самом значении находит последующий разбор
+        const char first = buffer_[pos_];
+        if (first != '"' && first != '[' && first != '{') {
+            while (true) {
+                if (pos_ == buffer_.size() && !Fill(begin)) {
+                    return;
+                }
+                const char c = buffer_[pos_];
+                if (IsSpace(c) || c == ',' || c == ':' || c == ']' || c == '}' || c == '"' || c == '[' || c == '{') {
+                    return;
+                }
+                ++pos_;
+            }
+        }
+        int depth = 0;
+        bool in_string = false;
+        bool escaped = false;
+        while (true) {
+            if (pos_ == buffer_.size() && !Fill(begin)) {
+                return;
+            }
+            if (in_string) {
+                if (escaped) {
+                    escaped = false;
+                    ++pos_;
+                    continue;
+                }
+                const char* data = buffer_.data();
+                pos_ = GetScanKernels().find_string_special(data + pos_, data + buffer_.size()) - data;
+                if (pos_ == buffer_.size()) {
+                    continue;
+                }
+                const char c = buffer_[pos_++];
+                if (c == '"') {
+                    in_string = false;
+                    if (depth == 0) {
+                        return;
+                    }
+                } else if (c == '\\') {
+                    escaped = true;
+                } else if (c == '\n' || c == '\r') {
+                    // Строка некорректна, дальше искать её конец незачем
+                    return;
+                }
+                continue;
+            }
+            const char c = buffer_[pos_++];
+            if (c == '"') {
+                in_string = true;
+            } else if (c == '[' || c == '{') {
+                ++depth;
+            } else if ((c == ']' || c == '}') && --depth == 0) {
+                return;
+            }
+        }
+    }
+
+    void Reader::BeginArray() {
+        if (PeekToken() != '[') {
+            throw ParsingError("Array is expected"s);
+        }
+        ++pos_;
+    }
+
+    void Reader::BeginDict() {
+        if (PeekToken() != '{') {
+            throw ParsingError("Dictionary is expected"s);
+        }
+        ++pos_;
+    }
+
+    bool Reader::NextItem() {
+        const int c = PeekToken();
+        if (c == EOF) {
+            throw ParsingError("Array parsing error"s);
+        }
+        if (c == ']') {
+            ++pos_;
+            return false;
+        }
+        if (c == ',') {
+            ++pos_;
+        }
+        return true;
+    }
+
+    bool Reader::NextKey(std::string& key) {
+        while (true) {
+            const int c = PeekToken();
+            if (c == EOF) {
+                throw ParsingError("Dictionary parsing error"s);
+            }
+            if (c == '}') {
+                ++pos_;
+                return false;
+            }
+            if (c == ',') {
+                ++pos_;
+                continue;
+            }
+            if (c != '"') {
+                throw ParsingError(R"(',' is expected but ')"s + static_cast<char>(c) + "' has been found"s);
+            }
+            key = ReadString();
+            if (const int colon = PeekToken(); colon != ':') {
+                throw ParsingError(": is expected but '"s + static_cast<char>(colon) + "' has been found"s);
+            }
+            ++pos_;
+            return true;
+        }
+    }
+
+    Node Reader::ReadNode() {
+        if (PeekToken() == EOF) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        size_t begin = pos_;
+        SkipValue(begin);
+        Cursor cursor{buffer_.data() + begin, buffer_.data() + pos_};
+        Node node = LoadNode(cursor);
+        // Непрочитанный остаток отрезка разбирается как следующее значение, как в Load
+        pos_ = static_cast<size_t>(cursor.pos - buffer_.data());
+        return node;
+    }
+
+    std::string Reader::ReadString() {
+        if (PeekToken() != '"') {
+            throw ParsingError("String is expected"s);
+        }
+        size_t begin = pos_;
+        SkipValue(begin);
+        Cursor cursor{buffer_.data() + begin + 1, buffer_.data() + pos_};
+        std::string result = LoadString(cursor);
+        pos_ = static_cast<size_t>(cursor.pos - buffer_.data());
+        return result;
+    }
+
+    int Reader::ReadInt() {
+        return ReadNode().AsInt();
+    }
+
+    double Reader::ReadDouble() {
+        return ReadNode().AsDouble();
+    }
+
+    bool Reader::ReadBool() {
+        return ReadNode().AsBool();
+    }
+
+    void Reader::Skip() {
+        if (PeekToken() == EOF) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        size_t begin = pos_;
+        SkipValue(begin);
+    }
+
 }  // namespace json
\ No newline at end of file
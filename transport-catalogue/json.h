@@ -3,6 +3,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -140,8 +141,53 @@ namespace json {
         return !(lhs == rhs);
     }
 
+    // Разбор документа из непрерывного буфера
+    Document Load(std::string_view text);
+    // Поток читается в буфер целиком, затем разбирается как Load(std::string_view)
     Document Load(std::istream& input);
 
     void Print(const Document& doc, std::ostream& output);
 
+    // Потоковое чтение документа без построения дерева: текст подгружается из потока блоками,
+    // а значения читаются по мере продвижения по нему. Массивы и словари обходятся поэлементно
+    // (BeginArray/NextItem, BeginDict/NextKey), остальные значения читаются целиком.
+    // Память ограничена размером блока и самого большого значения, прочитанного через ReadNode.
+    // Грамматика та же, что у Load, но повторные ключи словаря, обходимого через NextKey, не проверяются
+    class Reader {
+    public:
+        explicit Reader(std::istream& input);
+
+        // Открывающая скобка массива / словаря
+        void BeginArray();
+        void BeginDict();
+
+        // Есть ли в массиве следующий элемент; в конце массива читается закрывающая скобка
+        bool NextItem();
+        // Следующий ключ словаря вместе с двоеточием; в конце словаря читается закрывающая скобка
+        bool NextKey(std::string& key);
+
+        // Значение целиком
+        Node ReadNode();
+        std::string ReadString();
+        int ReadInt();
+        double ReadDouble();
+        bool ReadBool();
+        // Пропуск значения без разбора
+        void Skip();
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        // Следующий непробельный символ без его чтения или EOF
+        int PeekToken();
+        // Подгружаем следующий блок; часть буфера до keep отбрасывается, keep и позиция сдвигаются
+        bool Fill(size_t& keep);
+        // Переходим за конец значения, начинающегося в позиции begin
+        void SkipValue(size_t& begin);
+
+        std::istream& input_;
+        std::string buffer_;
+        size_t pos_ = 0;
+    };
+
 }  // namespace json
\ No newline at end of file
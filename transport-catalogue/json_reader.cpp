@@ -1,92 +1,215 @@
 #include "json_reader.h"
 
-#include <set>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace json_reader {
     using namespace std;
     using namespace std::literals;
 
+    namespace {
+        // Ответ на запрос, для которого ничего не найдено
+        void WriteNotFound(const json::Dict& request, json::Writer& writer) {
+            writer.StartDict()
+                    .Key("error_message"sv).Value("not found"sv)
+                    .Key("request_id"sv).Value(request.at("id"s).AsInt())
+                .EndDict();
+        }
+
+        // Ответ на некорректный запрос: сообщение об ошибке и номер запроса, если он есть
+        void WriteError(const json::Node& request, std::string_view message, json::Writer& writer) {
+            writer.StartDict();
+            writer.Key("error_message"sv).Value(message);
+            if (request.IsDict()) {
+                const json::Dict& request_info = request.AsDict();
+                if (const auto it = request_info.find("id"s); it != request_info.end() && it->second.IsInt()) {
+                    writer.Key("request_id"sv).Value(it->second.AsInt());
+                }
+            }
+            writer.EndDict();
+        }
+
+        // Буфер потока, который дописывает текст в строку вызывающего: в отличие от std::ostringstream
+        // готовый текст не приходится копировать из потока
+        class StringOutputBuffer : public std::streambuf {
+        public:
+            explicit StringOutputBuffer(std::string& text)
+                : text_(text) {
+            }
+
+        protected:
+            int_type overflow(int_type c) override {
+                if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                    text_ += traits_type::to_char_type(c);
+                }
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn(const char* text, std::streamsize count) override {
+                text_.append(text, static_cast<size_t>(count));
+                return count;
+            }
+
+        private:
+            std::string& text_;
+        };
+    }
+
     void GetRouteRequest(const json::Dict& request, request_handler::RequestHandler& request_handler,
-                         json::Builder& builder) {
+                         json::Writer& writer) {
         using namespace transport_router;
         using RouteInfo = std::optional<TransportRouter::RouteInfo>;
+        // Необязательные bus_velocity и bus_wait_time заменяют настройки маршрутизатора для этого запроса
+        TransportRouter::RouteSettings profile = request_handler.GetRouteSettings();
+        if (const auto it = request.find("bus_velocity"s); it != request.end()) {
+            profile.velocity = it->second.AsDouble();
+        }
+        if (const auto it = request.find("bus_wait_time"s); it != request.end()) {
+            profile.wait_time = it->second.AsInt();
+        }
         RouteInfo route_info = request_handler.GetRouteInfo(request.at("from").AsString(),
-                                                            request.at("to").AsString());
+                                                            request.at("to").AsString(), profile);
 
         if (route_info) {
-            builder.StartDict()
-                    .Key("request_id"s).Value(request.at("id"s).AsInt())
-                    .Key("total_time"s).Value(route_info.value().time)
-                    .Key("items"s).StartArray();
+            writer.StartDict()
+                    .Key("items"sv).StartArray();
             for (const auto& item : route_info.value().items) {
                 if (item.type == TransportRouter::ItemType::WAIT) {
-                    builder.StartDict().Key("type"s).Value("Wait"s)
-                        .Key("stop_name"s).Value(std::string(item.route_name))
-                        .Key("time"s).Value(item.time)
+                    writer.StartDict()
+                        .Key("stop_name"sv).Value(item.route_name)
+                        .Key("time"sv).Value(item.time)
+                        .Key("type"sv).Value("Wait"sv)
                     .EndDict();
                 } else if (item.type == TransportRouter::ItemType::BUS) {
-                    builder.StartDict().Key("type"s).Value("Bus"s)
-                        .Key("bus"s).Value(std::string(item.route_name))
-                        .Key("span_count"s).Value(item.span_count)
-                        .Key("time"s).Value(item.time)
+                    writer.StartDict()
+                        .Key("bus"sv).Value(item.route_name)
+                        .Key("span_count"sv).Value(item.span_count)
+                        .Key("time"sv).Value(item.time)
+                        .Key("type"sv).Value("Bus"sv)
                     .EndDict();
                 }
             }
-            builder.EndArray().EndDict();
-        } else {
-            builder.StartDict().Key("request_id"s).Value(request.at("id"s).AsInt())
-                    .Key("error_message"s).Value("not found"s)
+            writer.EndArray()
+                    .Key("request_id"sv).Value(request.at("id"s).AsInt())
+                    .Key("total_time"sv).Value(route_info.value().time)
                     .EndDict();
+        } else {
+            WriteNotFound(request, writer);
         }
     }
 
+    void GetRouteMatrixRequest(const json::Dict& request, request_handler::RequestHandler& request_handler,
+                               json::Writer& writer) {
+        auto get_stop_names = [](const json::Node& stops) {
+            std::vector<std::string_view> stop_names;
+            for (const auto& stop : stops.AsArray()) {
+                stop_names.push_back(stop.AsString());
+            }
+            return stop_names;
+        };
+        const auto time_matrix = request_handler.GetTimeMatrix(get_stop_names(request.at("from"s)),
+                                                               get_stop_names(request.at("to"s)));
+        if (!time_matrix) {
+            WriteNotFound(request, writer);
+            return;
+        }
+        writer.StartDict()
+                .Key("request_id"sv).Value(request.at("id"s).AsInt())
+                .Key("times"sv).StartArray();
+        for (const auto& row : *time_matrix) {
+            writer.StartArray();
+            for (const auto& time : row) {
+                if (time) {
+                    writer.Value(*time);
+                } else {
+                    writer.Value(nullptr);
+                }
+            }
+            writer.EndArray();
+        }
+        writer.EndArray().EndDict();
+    }
+
+    void GetNearestStopsRequest(const json::Dict& request, request_handler::RequestHandler& request_handler,
+                                json::Writer& writer) {
+        // Нужен хотя бы один из параметров: count (k ближайших) или radius (все в радиусе, метры)
+        const auto count_it = request.find("count"s);
+        const auto radius_it = request.find("radius"s);
+        if (count_it == request.end() && radius_it == request.end()) {
+            throw std::invalid_argument("NearestStops request needs count or radius"s);
+        }
+        const size_t count = count_it != request.end() ? static_cast<size_t>(std::max(count_it->second.AsInt(), 0))
+                                                       : std::numeric_limits<size_t>::max();
+        const double radius = radius_it != request.end() ? radius_it->second.AsDouble()
+                                                         : std::numeric_limits<double>::infinity();
+        const geo::Coordinates point = {request.at("latitude"s).AsDouble(), request.at("longitude"s).AsDouble()};
+        writer.StartDict()
+                .Key("request_id"sv).Value(request.at("id"s).AsInt())
+                .Key("stops"sv).StartArray();
+        for (const auto& stop : request_handler.GetNearestStops(point, count, radius)) {
+            writer.StartDict()
+                    .Key("distance"sv).Value(stop.distance)
+                    .Key("name"sv).Value(stop.name)
+                .EndDict();
+        }
+        writer.EndArray().EndDict();
+    }
+
     void GetMapRequest(const json::Dict& request, request_handler::RequestHandler& request_handler,
-                       json::Builder& builder) {
-        std::ostringstream out;
+                       json::Writer& writer) {
+        std::string svg_text;
+        StringOutputBuffer buffer(svg_text);
+        std::ostream out(&buffer);
         svg::Document svg_map = request_handler.RenderMap();
         svg_map.Render(out);
-        builder.StartDict()
-                .Key("request_id"s).Value(request.at("id"s).AsInt())
-                .Key("map"s).Value(out.str())
+        writer.StartDict()
+                .Key("map"sv).Value(std::string_view(svg_text))
+                .Key("request_id"sv).Value(request.at("id"s).AsInt())
             .EndDict();
     }
 
     void GetStopInfoForOutput(const json::Dict& request, request_handler::RequestHandler& request_handler,
-                              json::Builder& builder) {
+                              json::Writer& writer) {
         std::optional<StopInfo> stop_info = request_handler.GetBusesByStop(request.at("name"s).AsString());
-        builder.StartDict()
-            .Key("request_id"s).Value(request.at("id"s).AsInt());
-        std::set<std::string_view> sort_buses;
-        if (stop_info) {
-            builder.Key("buses"s).StartArray();
-            for (const auto& route : stop_info->buses) {
-                sort_buses.insert(route);
-            }
-            for (const auto& bus : sort_buses) {
-                builder.Value(static_cast<string>(bus));
-            }
-            builder.EndArray();
-        } else {
-            builder.Key("error_message"s).Value(R"(not found)"s);
+        if (!stop_info) {
+            WriteNotFound(request, writer);
+            return;
+        }
+        writer.StartDict()
+                .Key("buses"sv).StartArray();
+        for (const auto& bus : stop_info->buses) {
+            writer.Value(bus);
         }
-        builder.EndDict();
+        writer.EndArray()
+                .Key("request_id"sv).Value(request.at("id"s).AsInt())
+            .EndDict();
     }
 
     void GetBusInfoForOutput(const json::Dict& request, request_handler::RequestHandler& request_handler,
-                             json::Builder& builder) {
+                             json::Writer& writer) {
         std::optional<BusInfo> bus_info = request_handler.GetBusStat(request.at("name"s).AsString());
-        builder.StartDict()
-                .Key("request_id"s).Value(request.at("id"s).AsInt());
-        if (bus_info) {
-            builder.Key("curvature"s).Value(bus_info->curvature)
-                .Key("route_length"s).Value(bus_info->route_length)
-                .Key("stop_count"s).Value(bus_info->stops_count)
-                .Key("unique_stop_count"s).Value(bus_info->unique_stops_count);
-        } else {
-            builder.Key("error_message"s).Value(R"(not found)"s);
+        if (!bus_info) {
+            WriteNotFound(request, writer);
+            return;
         }
-        builder.EndDict();
+        writer.StartDict()
+                .Key("curvature"sv).Value(bus_info->curvature)
+                .Key("request_id"sv).Value(request.at("id"s).AsInt())
+                .Key("route_length"sv).Value(bus_info->route_length)
+                .Key("stop_count"sv).Value(bus_info->stops_count)
+                .Key("unique_stop_count"sv).Value(bus_info->unique_stops_count)
+            .EndDict();
     }
 
     std::vector<std::string_view> GetStopsFromBusInfo(const json::Dict& bus_info) {
@@ -102,7 +225,11 @@ namespace json_reader {
         bus.name = bus_info.at("name"s).AsString();
         bus.is_round_route = bus_info.at("is_roundtrip"s).AsBool();
         for (const auto& stop : GetStopsFromBusInfo(bus_info)) {
-            bus.stops.push_back(catalogue.FindStop(stop));
+            const Stop* stop_ptr = catalogue.FindStop(stop);
+            if (stop_ptr == nullptr) {
+                throw std::invalid_argument("Unknown stop on bus route");
+            }
+            bus.stops.push_back(stop_ptr->id);
         }
         if (!bus.is_round_route) {
             for (int i = (static_cast<int>(bus.stops.size()) - 2); i >= 0; --i) {
@@ -124,7 +251,10 @@ namespace json_reader {
         const Stop* source = catalogue.FindStop(stop_info.at("name"s).AsString());
         const json::Dict road_distances = stop_info.at("road_distances"s).AsDict();
         for (const auto& [destination, distance] : road_distances) {
-            catalogue.SetDistance(source, catalogue.FindStop(destination), distance.AsInt());
+            // Расстояния до остановок, которых нет в базе, не используются
+            if (const Stop* destination_ptr = catalogue.FindStop(destination)) {
+                catalogue.SetDistance(source->id, destination_ptr->id, distance.AsInt());
+            }
         }
     }
 
@@ -212,26 +342,375 @@ namespace json_reader {
         for (const auto& bus : requests.buses) {
             catalogue.AddBus(SetBusFromJsonRequest(catalogue, bus.AsDict()));
         }
+        catalogue.BuildSpatialIndex();
+        catalogue.BuildNameIndexes();
+    }
+
+    bool GetOutputJsonResponse(const json::Dict& request, request_handler::RequestHandler& request_handler,
+                               json::Writer& writer) {
+        const std::string& type = request.at("type"s).AsString();
+        if (type == "Stop"s) {
+            GetStopInfoForOutput(request, request_handler, writer);
+        } else if (type == "Bus"s) {
+            GetBusInfoForOutput(request, request_handler, writer);
+        } else if (type == "Map"s) {
+            GetMapRequest(request, request_handler, writer);
+        } else if (type == "Route"s) {
+            GetRouteRequest(request, request_handler, writer);
+        } else if (type == "RouteMatrix"s) {
+            GetRouteMatrixRequest(request, request_handler, writer);
+        } else if (type == "NearestStops"s) {
+            GetNearestStopsRequest(request, request_handler, writer);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    void UpdateStopFromJsonRequest(transport_catalogue::TransportCatalogue& catalogue, const json::Dict& stop_info) {
+        const Stop stop = SetStopFromJsonRequest(stop_info);
+        if (const Stop* existing = catalogue.FindStop(stop.name)) {
+            catalogue.UpdateStop(existing->id, stop.coordinates);
+        } else {
+            catalogue.AddStop(stop);
+        }
+        if (stop_info.count("road_distances"s)) {
+            SetDistanceBetweenStops(catalogue, stop_info);
+        }
     }
 
-    void GetOutputJsonRequest(request_handler::RequestHandler& request_handler, const json::Array& request_info,
-                              [[maybe_unused]] ostream& output) {
-        json::Builder builder;
-        builder.StartArray();
-        for (const auto& output_requests : request_info) {
-            json::Dict request = output_requests.AsDict();
-            if (request.at("type"s).AsString() == "Stop"s) {
-                GetStopInfoForOutput(request, request_handler, builder) ;
-            } else if (request.at("type"s).AsString() == "Bus"s) {
-                GetBusInfoForOutput(request, request_handler, builder);
-            } else if (request.at("type"s).AsString() == "Map"s) {
-                GetMapRequest(request, request_handler, builder);
-            } else if (request.at("type"s).AsString() == "Route"s) {
-                GetRouteRequest(request, request_handler, builder);
-            }
-        }
-        builder.EndArray();
-        json::Print(json::Document{builder.Build()}, output);
+    void UpdateBusFromJsonRequest(transport_catalogue::TransportCatalogue& catalogue, const json::Dict& bus_info) {
+        Bus bus = SetBusFromJsonRequest(catalogue, bus_info);
+        if (const Bus* existing = catalogue.FindBus(bus.name)) {
+            catalogue.UpdateBus(existing->id, std::move(bus.stops), bus.is_round_route);
+        } else {
+            catalogue.AddBus(bus);
+        }
+    }
+
+    namespace {
+        // Выполнение stat_requests по версиям справочника. Запрос чтения получает снимок, текущий на момент
+        // его чтения, и выполняется в пуле потоков вместе с другими запросами пачки. Запрос изменения
+        // сразу публикует новую версию, не дожидаясь ответов на прочитанные раньше запросы: пока одна пачка
+        // выполняется, следующая читается, и изменения в ней применяются. Пачка - все запросы, прочитанные
+        // за время выполнения предыдущей (не больше BATCH_SIZE), поэтому первый запрос выполняется сразу.
+        // Ответы пачки выводятся в порядке запросов, как только она выполнена
+        class StatRequestExecutor {
+        public:
+            StatRequestExecutor(const transport_catalogue::TransportCatalogue& catalogue,
+                                const renderer::MapRenderer& map_renderer,
+                                const transport_router::TransportRouter& router, ostream& output)
+                : store_(MakeUnowned(catalogue), MakeUnowned(router))
+                , map_renderer_(map_renderer)
+                , output_(output)
+                , writer_(output) {
+                writer_.StartArray();
+                answer_thread_ = std::thread([this] {
+                    AnswerBatches();
+                });
+            }
+
+            StatRequestExecutor(const StatRequestExecutor&) = delete;
+            StatRequestExecutor& operator=(const StatRequestExecutor&) = delete;
+
+            ~StatRequestExecutor() {
+                if (answer_thread_.joinable()) {
+                    Stop();
+                }
+            }
+
+            void Execute(json::Node request) {
+                // Запрос без типа выполняется как запрос чтения и получает ответ с ошибкой
+                std::string_view type;
+                if (request.IsDict()) {
+                    const json::Dict& request_info = request.AsDict();
+                    if (const auto it = request_info.find("type"s); it != request_info.end() && it->second.IsString()) {
+                        type = it->second.AsString();
+                    }
+                }
+                Response response;
+                if (type == "UpdateStop"s || type == "UpdateBus"s) {
+                    response.text = Update(request);
+                } else if (type == "UpdateRoutingSettings"s) {
+                    response.text = UpdateRouteSettings(request);
+                } else {
+                    response.snapshot = store_.GetSnapshot();
+                    response.request = std::move(request);
+                }
+                std::unique_lock lock(mutex_);
+                // Чтение ждёт, пока не выполнится пачка, только если следующая уже набрана
+                space_cv_.wait(lock, [this] {
+                    return pending_.size() < BATCH_SIZE || error_;
+                });
+                if (error_) {
+                    std::rethrow_exception(error_);
+                }
+                pending_.push_back(std::move(response));
+                work_cv_.notify_one();
+            }
+
+            // Дожидаемся всех ответов и закрываем массив
+            void Finish() {
+                Stop();
+                if (error_) {
+                    std::rethrow_exception(error_);
+                }
+                writer_.EndArray();
+            }
+
+        private:
+            static constexpr size_t BATCH_SIZE = 256;
+
+            struct Response {
+                std::shared_ptr<const transport_catalogue::Snapshot> snapshot; // пустой у запросов изменения
+                json::Node request;
+                std::string text; // пустой, если тип запроса неизвестен
+            };
+
+            // Справочник и маршрутизатор первой версии принадлежат вызывающему и живут дольше исполнителя
+            template <typename Object>
+            static std::shared_ptr<const Object> MakeUnowned(const Object& object) {
+                return std::shared_ptr<const Object>(&object, [](const Object*) {
+                });
+            }
+
+            // Запрос изменения без нужных ключей или с неверными значениями получает ответ с ошибкой,
+            // версия справочника при этом не меняется
+            std::string Update(const json::Node& request) {
+                static const std::vector<std::string> STOP_KEYS = {"id"s, "name"s, "latitude"s, "longitude"s};
+                static const std::vector<std::string> BUS_KEYS = {"id"s, "name"s, "stops"s, "is_roundtrip"s};
+                const json::Dict& request_info = request.AsDict();
+                const std::string& type = request_info.at("type"s).AsString();
+                const auto& required_keys = type == "UpdateStop"s ? STOP_KEYS : BUS_KEYS;
+                std::ostringstream out;
+                json::Writer writer(out, 1);
+                if (!HasKeys(request_info, required_keys)) {
+                    WriteError(request, "Incomplete update request"sv, writer);
+                    writer.Flush();
+                    return out.str();
+                }
+                try {
+                    const int request_id = request_info.at("id"s).AsInt();
+                    const auto snapshot = store_.Update(
+                            [&request_info, &type](transport_catalogue::TransportCatalogue& catalogue) {
+                                if (type == "UpdateStop"s) {
+                                    UpdateStopFromJsonRequest(catalogue, request_info);
+                                } else {
+                                    UpdateBusFromJsonRequest(catalogue, request_info);
+                                }
+                            });
+                    WriteVersion(request_id, *snapshot, writer);
+                } catch (const std::invalid_argument&) {
+                    // Остановки маршрута нет в справочнике
+                    WriteNotFound(request_info, writer);
+                } catch (const std::exception& e) {
+                    WriteError(request, e.what(), writer);
+                }
+                writer.Flush();
+                return out.str();
+            }
+
+            // Скорость автобусов и время ожидания меняются без перестройки графа маршрутов
+            std::string UpdateRouteSettings(const json::Node& request) {
+                std::ostringstream out;
+                json::Writer writer(out, 1);
+                try {
+                    const json::Dict& request_info = request.AsDict();
+                    auto route_settings = store_.GetSnapshot()->router->GetSettings();
+                    if (const auto it = request_info.find("bus_velocity"s); it != request_info.end()) {
+                        route_settings.velocity = it->second.AsDouble();
+                    }
+                    if (const auto it = request_info.find("bus_wait_time"s); it != request_info.end()) {
+                        route_settings.wait_time = it->second.AsInt();
+                    }
+                    if (!(route_settings.velocity > 0) || route_settings.wait_time < 0) {
+                        throw std::invalid_argument("Bus velocity should be positive and wait time non-negative");
+                    }
+                    const int request_id = request_info.at("id"s).AsInt();
+                    WriteVersion(request_id, *store_.UpdateRouteSettings(route_settings), writer);
+                } catch (const std::exception& e) {
+                    WriteError(request, e.what(), writer);
+                }
+                writer.Flush();
+                return out.str();
+            }
+
+            // В запросе есть все ключи keys
+            static bool HasKeys(const json::Dict& request, const std::vector<std::string>& keys) {
+                return std::all_of(keys.begin(), keys.end(), [&request](const std::string& key) {
+                    return request.count(key) > 0;
+                });
+            }
+
+            // Ответ на запрос изменения: номер опубликованной версии
+            static void WriteVersion(int request_id, const transport_catalogue::Snapshot& snapshot,
+                                     json::Writer& writer) {
+                writer.StartDict()
+                        .Key("request_id"sv).Value(request_id)
+                        .Key("version"sv).Value(static_cast<int>(snapshot.version))
+                    .EndDict();
+            }
+
+            // Запросов больше не будет: дожидаемся выполнения прочитанных
+            void Stop() {
+                {
+                    std::lock_guard lock(mutex_);
+                    is_finished_ = true;
+                }
+                work_cv_.notify_one();
+                answer_thread_.join();
+            }
+
+            // Поток ответов: забираем все прочитанные запросы, выполняем их в пуле и выводим ответы
+            void AnswerBatches() {
+                std::vector<Response> batch;
+                try {
+                    while (true) {
+                        {
+                            std::unique_lock lock(mutex_);
+                            work_cv_.wait(lock, [this] {
+                                return !pending_.empty() || is_finished_;
+                            });
+                            if (pending_.empty()) {
+                                return;
+                            }
+                            std::swap(pending_, batch);
+                        }
+                        space_cv_.notify_one();
+                        pool_.Run(batch.size(), [this, &batch](size_t index) {
+                            Answer(batch[index]);
+                        });
+                        for (const Response& response : batch) {
+                            if (!response.text.empty()) {
+                                writer_.RawValue(response.text);
+                            }
+                        }
+                        // Ответы пачки сразу уходят из буферов вывода
+                        writer_.Flush();
+                        output_.flush();
+                        batch.clear();
+                    }
+                } catch (...) {
+                    std::lock_guard lock(mutex_);
+                    error_ = std::current_exception();
+                    space_cv_.notify_one();
+                }
+            }
+
+            void Answer(Response& response) const {
+                if (!response.snapshot) {
+                    return;
+                }
+                try {
+                    std::ostringstream out;
+                    json::Writer writer(out, 1);
+                    request_handler::RequestHandler request_handler(*response.snapshot->catalogue, map_renderer_,
+                                                                    *response.snapshot->router);
+                    if (GetOutputJsonResponse(response.request.AsDict(), request_handler, writer)) {
+                        writer.Flush();
+                        response.text = out.str();
+                    }
+                } catch (const std::exception& e) {
+                    // Некорректный запрос (нет нужного ключа, неверный тип значения) получает ответ с ошибкой,
+                    // остальные запросы пачки выполняются
+                    std::ostringstream out;
+                    json::Writer writer(out, 1);
+                    WriteError(response.request, e.what(), writer);
+                    writer.Flush();
+                    response.text = out.str();
+                }
+                // Версия справочника освобождается, как только на неё не осталось запросов
+                response.snapshot.reset();
+            }
+
+            transport_catalogue::SnapshotStore store_;
+            const renderer::MapRenderer& map_renderer_;
+            ostream& output_;
+            json::Writer writer_;
+            graph::detail::ThreadPool pool_;
+            std::mutex mutex_;
+            std::condition_variable work_cv_; // Есть прочитанные запросы или чтение закончено
+            std::condition_variable space_cv_; // В следующей пачке есть место или выполнение прервано
+            std::vector<Response> pending_; // Прочитаны, ещё не выполняются
+            bool is_finished_ = false; // Все запросы прочитаны
+            std::exception_ptr error_; // Исключение, прервавшее выполнение пачек
+            std::thread answer_thread_; // Выполняет пачки и выводит ответы (AnswerBatches)
+        };
+    }
+
+    void GetOutputJsonRequest(const transport_catalogue::TransportCatalogue& catalogue,
+                              const renderer::MapRenderer& map_renderer,
+                              const transport_router::TransportRouter& router,
+                              const json::Array& request_info, ostream& output) {
+        StatRequestExecutor executor(catalogue, map_renderer, router, output);
+        for (const auto& request : request_info) {
+            executor.Execute(request);
+        }
+        executor.Finish();
+    }
+
+    void ReadOutputJsonRequest(const transport_catalogue::TransportCatalogue& catalogue,
+                               const renderer::MapRenderer& map_renderer,
+                               const transport_router::TransportRouter& router,
+                               json::Reader& reader, ostream& output) {
+        StatRequestExecutor executor(catalogue, map_renderer, router, output);
+        reader.BeginArray();
+        while (reader.NextItem()) {
+            executor.Execute(reader.ReadNode());
+        }
+        executor.Finish();
+    }
+
+    transport_router::TransportRouter::RouterType GetRouterTypeFromRequest(const std::string& router_type) {
+        using RouterType = transport_router::TransportRouter::RouterType;
+        if (router_type == "all_pairs"s) {
+            return RouterType::ALL_PAIRS;
+        } else if (router_type == "dijkstra"s) {
+            return RouterType::DIJKSTRA;
+        } else if (router_type == "contraction_hierarchy"s) {
+            return RouterType::CONTRACTION_HIERARCHY;
+        } else if (router_type == "all_pairs_compact"s) {
+            return RouterType::ALL_PAIRS_COMPACT;
+        } else if (router_type == "astar"s) {
+            return RouterType::ASTAR;
+        } else {
+            throw std::invalid_argument("Incorrect router type in routing settings"s);
+        }
+    }
+
+    transport_router::TransportRouter::GraphModel GetGraphModelFromRequest(const std::string& graph_model) {
+        using GraphModel = transport_router::TransportRouter::GraphModel;
+        if (graph_model == "span_edges"s) {
+            return GraphModel::SPAN_EDGES;
+        } else if (graph_model == "line_vertices"s) {
+            return GraphModel::LINE_VERTICES;
+        } else {
+            throw std::invalid_argument("Incorrect graph model in routing settings"s);
+        }
+    }
+
+    geo::DistanceMode GetDistanceModeFromRequest(const std::string& distance_mode) {
+        if (distance_mode == "spherical"s) {
+            return geo::DistanceMode::SPHERICAL;
+        } else if (distance_mode == "equirectangular"s) {
+            return geo::DistanceMode::EQUIRECTANGULAR;
+        } else {
+            throw std::invalid_argument("Incorrect distance mode in geo settings"s);
+        }
+    }
+
+    void GetGeoJsonRequest(transport_catalogue::TransportCatalogue& catalogue, const json::Dict& request_info) {
+        transport_catalogue::TransportCatalogue::GeoSettings geo_settings;
+        for (const auto& [setting, value] : request_info) {
+            if (setting == "distance_mode"s) {
+                geo_settings.distance_mode = GetDistanceModeFromRequest(value.AsString());
+            } else if (setting == "compact_coordinates"s) {
+                geo_settings.compact_coordinates = value.AsBool();
+            } else {
+                throw std::invalid_argument("Incorrect types of geo settings"s);
+            }
+        }
+        catalogue.SetGeoSettings(geo_settings);
     }
 
     void GetRouteJsonRequest(transport_router::TransportRouter& router, const json::Dict &request_info) {
@@ -242,6 +721,10 @@ namespace json_reader {
                 r_settings.velocity = value.AsDouble();
             } else if (setting == "bus_wait_time"s) {
                 r_settings.wait_time = value.AsInt();
+            } else if (setting == "router_type"s) {
+                r_settings.router_type = GetRouterTypeFromRequest(value.AsString());
+            } else if (setting == "graph_model"s) {
+                r_settings.graph_model = GetGraphModelFromRequest(value.AsString());
             } else {
                 throw std::invalid_argument("Incorrect types of routing settings"s);
             }
@@ -253,17 +736,23 @@ namespace json_reader {
                         renderer::MapRenderer& map_renderer,
                         transport_router::TransportRouter& router,
                         istream& input, ostream& output) {
-        request_handler::RequestHandler request_handler(catalogue, map_renderer, router);
         json::Document requests = json::Load(input);
-        for (const auto& [request_type, request_info] : requests.GetRoot().AsDict()) {
+        // Геометрия задаётся до добавления остановок, а ключи словаря идут по алфавиту
+        const json::Dict& root = requests.GetRoot().AsDict();
+        if (const auto it = root.find("geo_settings"s); it != root.end()) {
+            GetGeoJsonRequest(catalogue, it->second.AsDict());
+        }
+        for (const auto& [request_type, request_info] : root) {
             if (request_type == "base_requests"s) {
                 GetInputJsonRequest(catalogue, request_info.AsArray());
+            } else if (request_type == "geo_settings"s) {
+                // Настройки уже применены
             } else if (request_type == "render_settings"s) {
                 GetRenderJsonRequest(map_renderer, request_info.AsDict());
             } else if (request_type == "routing_settings"s) {
                 GetRouteJsonRequest(router, request_info.AsDict());
             } else if (request_type == "stat_requests"s) {
-                GetOutputJsonRequest(request_handler, request_info.AsArray(), output);
+                GetOutputJsonRequest(catalogue, map_renderer, router, request_info.AsArray(), output);
             } else {
                 throw std::invalid_argument("Incorrect JSON request"s);
             }
@@ -274,14 +763,182 @@ namespace json_reader {
         serializer.SetSetting(request_info.at("file").AsString());
     }
 
+    namespace {
+        // Отложенные данные потоковой загрузки: названия остановок, на которые ссылаются расстояния
+        // и маршруты, хранятся один раз, а записи ссылаются на них номерами
+        class InputStaging {
+        public:
+            uint32_t GetNameId(std::string_view name) {
+                uint32_t id = names_.Find(name);
+                if (id == transport_catalogue::NameArena::NO_ID) {
+                    id = static_cast<uint32_t>(name_views_.size());
+                    name_views_.push_back(names_.Add(name, id));
+                }
+                return id;
+            }
+
+            void AddDistance(StopId from, std::string_view to, int distance) {
+                distances_.push_back({from, GetNameId(to), distance});
+            }
+
+            void AddBus(std::string_view name, std::vector<uint32_t> stops, bool is_roundtrip) {
+                buses_.push_back({GetNameId(name), std::move(stops), is_roundtrip});
+            }
+
+            // Расстояния задаются, когда известны все остановки, затем добавляются маршруты
+            void Apply(transport_catalogue::TransportCatalogue& catalogue) {
+                std::vector<const Stop*> stops(name_views_.size());
+                for (size_t id = 0; id < name_views_.size(); ++id) {
+                    stops[id] = catalogue.FindStop(name_views_[id]);
+                }
+                for (const Distance& distance : distances_) {
+                    // Расстояния до остановок, которых нет в базе, не используются
+                    if (const Stop* destination = stops[distance.to]) {
+                        catalogue.SetDistance(distance.from, destination->id, distance.distance);
+                    }
+                }
+                distances_ = {};
+                for (PendingBus& pending : buses_) {
+                    Bus bus;
+                    bus.name = name_views_[pending.name];
+                    bus.is_round_route = pending.is_roundtrip;
+                    for (const uint32_t stop : pending.stops) {
+                        if (stops[stop] == nullptr) {
+                            throw std::invalid_argument("Unknown stop on bus route");
+                        }
+                        bus.stops.push_back(stops[stop]->id);
+                    }
+                    pending.stops = {};
+                    if (!bus.is_round_route) {
+                        for (int i = (static_cast<int>(bus.stops.size()) - 2); i >= 0; --i) {
+                            bus.stops.push_back(bus.stops[i]);
+                        }
+                    }
+                    catalogue.AddBus(bus);
+                }
+                buses_ = {};
+            }
+
+        private:
+            struct Distance {
+                StopId from;
+                uint32_t to; // номер названия
+                int distance;
+            };
+
+            struct PendingBus {
+                uint32_t name;
+                std::vector<uint32_t> stops; // номера названий
+                bool is_roundtrip;
+            };
+
+            transport_catalogue::NameArena names_;
+            std::vector<std::string_view> name_views_;
+            std::vector<Distance> distances_;
+            std::vector<PendingBus> buses_;
+        };
+
+        // Один запрос base_requests; ключи могут идти в любом порядке, поэтому тип известен только в конце
+        void ReadInputItem(transport_catalogue::TransportCatalogue& catalogue, json::Reader& reader,
+                           InputStaging& staging) {
+            std::string type;
+            std::optional<std::string> name;
+            std::optional<double> latitude;
+            std::optional<double> longitude;
+            std::vector<std::pair<std::string, int>> road_distances;
+            std::optional<std::vector<uint32_t>> stops;
+            std::optional<bool> is_roundtrip;
+
+            reader.BeginDict();
+            std::string key;
+            while (reader.NextKey(key)) {
+                if (key == "type"s) {
+                    type = reader.ReadString();
+                } else if (key == "name"s) {
+                    name = reader.ReadString();
+                } else if (key == "latitude"s) {
+                    latitude = reader.ReadDouble();
+                } else if (key == "longitude"s) {
+                    longitude = reader.ReadDouble();
+                } else if (key == "road_distances"s) {
+                    reader.BeginDict();
+                    std::string destination;
+                    while (reader.NextKey(destination)) {
+                        road_distances.emplace_back(std::move(destination), reader.ReadInt());
+                    }
+                } else if (key == "stops"s) {
+                    stops.emplace();
+                    reader.BeginArray();
+                    while (reader.NextItem()) {
+                        stops->push_back(staging.GetNameId(reader.ReadString()));
+                    }
+                } else if (key == "is_roundtrip"s) {
+                    is_roundtrip = reader.ReadBool();
+                } else {
+                    reader.Skip();
+                }
+            }
+
+            if (type == "Stop"s) {
+                if (!name || !latitude || !longitude) {
+                    throw std::out_of_range("Incomplete stop request"s);
+                }
+                Stop stop;
+                stop.name = std::move(*name);
+                stop.coordinates.lat = *latitude;
+                stop.coordinates.lng = *longitude;
+                catalogue.AddStop(stop);
+                const StopId id = static_cast<StopId>(catalogue.GetStopsCount() - 1);
+                for (const auto& [destination, distance] : road_distances) {
+                    staging.AddDistance(id, destination, distance);
+                }
+            } else if (type == "Bus"s) {
+                if (!name || !stops || !is_roundtrip) {
+                    throw std::out_of_range("Incomplete bus request"s);
+                }
+                staging.AddBus(*name, std::move(*stops), *is_roundtrip);
+            } else {
+                throw std::invalid_argument("Incorrect type of input request"s);
+            }
+        }
+    }
+
+    void ReadInputJsonRequest(transport_catalogue::TransportCatalogue& catalogue, json::Reader& reader) {
+        InputStaging staging;
+        reader.BeginArray();
+        while (reader.NextItem()) {
+            ReadInputItem(catalogue, reader, staging);
+        }
+        staging.Apply(catalogue);
+        catalogue.BuildSpatialIndex();
+        catalogue.BuildNameIndexes();
+    }
+
     void MakeBaseRequest(transport_catalogue::TransportCatalogue& catalogue,
                          renderer::MapRenderer& map_renderer,
                          transport_router::TransportRouter& router,
                          serialize::Serializer& serializer, istream& input) {
-        json::Document requests = json::Load(input);
-        for (const auto& [request_type, request_info] : requests.GetRoot().AsDict()) {
+        // base_requests загружаются потоково по мере чтения; остальные разделы невелики, читаются целиком
+        // и применяются после загрузки в алфавитном порядке ключей. geo_settings до base_requests применяются
+        // сразу, и координаты округляются при добавлении остановок
+        json::Reader reader(input);
+        json::Dict settings;
+        reader.BeginDict();
+        std::string request_type;
+        while (reader.NextKey(request_type)) {
             if (request_type == "base_requests"s) {
-                GetInputJsonRequest(catalogue, request_info.AsArray());
+                ReadInputJsonRequest(catalogue, reader);
+            } else if (request_type == "geo_settings"s && catalogue.GetStopsCount() == 0) {
+                GetGeoJsonRequest(catalogue, reader.ReadNode().AsDict());
+            } else {
+                settings.emplace(std::move(request_type), reader.ReadNode());
+            }
+        }
+        for (const auto& [request_type, request_info] : settings) {
+            if (request_type == "geo_settings"s) {
+                // Остановки уже добавлены: координаты и статистика маршрутов пересчитываются по настройкам
+                GetGeoJsonRequest(catalogue, request_info.AsDict());
+                catalogue.BuildSpatialIndex();
             } else if (request_type == "render_settings"s) {
                 GetRenderJsonRequest(map_renderer, request_info.AsDict());
             } else if (request_type == "routing_settings"s) {
@@ -299,17 +956,30 @@ namespace json_reader {
                         renderer::MapRenderer& map_renderer,
                         transport_router::TransportRouter& router,
                         serialize::Serializer& serializer, istream& input, ostream& output) {
-        json::Document requests = json::Load(input);
-        request_handler::RequestHandler request_handler(catalogue, map_renderer, router);
-        for (const auto& [request_type, request_info] : requests.GetRoot().AsDict()) {
+        // stat_requests выполняются по мере чтения, если база уже загружена. Иначе (serialization_settings
+        // идут в документе позже) массив читается целиком и выполняется после загрузки базы
+        json::Reader reader(input);
+        std::optional<json::Node> deferred_requests;
+        bool is_base_loaded = false;
+        reader.BeginDict();
+        std::string request_type;
+        while (reader.NextKey(request_type)) {
             if (request_type == "serialization_settings"s) {
-                GetSerializeJsonRequest(serializer, request_info.AsDict());
+                GetSerializeJsonRequest(serializer, reader.ReadNode().AsDict());
                 serializer.DeserializeFromFile();
+                is_base_loaded = true;
             } else if (request_type == "stat_requests"s) {
-                GetOutputJsonRequest(request_handler, request_info.AsArray(), output);
+                if (is_base_loaded) {
+                    ReadOutputJsonRequest(catalogue, map_renderer, router, reader, output);
+                } else {
+                    deferred_requests = reader.ReadNode();
+                }
             } else {
                 throw std::invalid_argument("Incorrect process JSON request"s);
             }
         }
+        if (deferred_requests) {
+            GetOutputJsonRequest(catalogue, map_renderer, router, deferred_requests->AsArray(), output);
+        }
     }
 }
\ No newline at end of file
@@ -1,12 +1,13 @@
 #pragma once
 
 #include "transport_catalogue.h"
-#include "json_builder.h"
+#include "json_writer.h"
 #include "request_handler.h"
 #include "map_renderer.h"
 #include "svg.h"
 #include "transport_router.h"
 #include "serialization.h"
+#include "snapshot_store.h"
 
 namespace json_reader {
     struct Requests {
@@ -18,17 +19,28 @@ namespace json_reader {
 
     // Обработка запроса на построение маршрута
     void GetRouteRequest(const json::Dict& request, request_handler::RequestHandler& request_handler,
-                         json::Builder& builder);
+                         json::Writer& writer);
+
+    // Обработка запроса на матрицу времени в пути между списками остановок
+    void GetRouteMatrixRequest(const json::Dict& request, request_handler::RequestHandler& request_handler,
+                               json::Writer& writer);
+
+    // Обработка запроса ближайших к точке остановок
+    void GetNearestStopsRequest(const json::Dict& request, request_handler::RequestHandler& request_handler,
+                                json::Writer& writer);
 
     // Обработка запроса на получение изображения
     void GetMapRequest(const json::Dict& request, request_handler::RequestHandler& request_handler,
-                       json::Builder& builder);
+                       json::Writer& writer);
+    // Ответ на один запрос stat_requests; false, если тип запроса неизвестен (такие запросы пропускаются)
+    bool GetOutputJsonResponse(const json::Dict& request, request_handler::RequestHandler& request_handler,
+                               json::Writer& writer);
     // Получаем инфо об остановке из справочника
     void GetStopInfoForOutput(const json::Dict& request, request_handler::RequestHandler& request_handler,
-                              json::Builder& builder);
+                              json::Writer& writer);
     // Получаем инфо о маршруте из справочника
     void GetBusInfoForOutput(const json::Dict& request, request_handler::RequestHandler& request_handler,
-                             json::Builder& builder);
+                             json::Writer& writer);
     // Получаем все остановки из информации о маршруте
     std::vector<std::string_view> GetStopsFromBusInfo(const json::Dict& bus_info);
 
@@ -44,17 +56,53 @@ namespace json_reader {
     //Выделяем цвет из соответствующего JSON-узла
     svg::Color GetColorFromRequest(const json::Node& color_request);
 
+    //Определяем движок маршрутизатора по его названию из настроек
+    transport_router::TransportRouter::RouterType GetRouterTypeFromRequest(const std::string& router_type);
+
+    //Определяем модель графа маршрутов по её названию из настроек
+    transport_router::TransportRouter::GraphModel GetGraphModelFromRequest(const std::string& graph_model);
+
+    //Определяем способ расчёта расстояния по его названию из настроек
+    geo::DistanceMode GetDistanceModeFromRequest(const std::string& distance_mode);
+
     //________________________Разбиваем JSON на типовые запросы
 
+    // Получаем настройки геометрии справочника (запрос geo_settings)
+    void GetGeoJsonRequest(transport_catalogue::TransportCatalogue& catalogue, const json::Dict& request_info);
+
     // Получаем параметры визуализатора (запрос render_settings)
     void GetRenderJsonRequest(renderer::MapRenderer& map_renderer, const json::Dict& request_info);
 
     // Добавляем информацию в базу (запрос base_requests)
     void GetInputJsonRequest(transport_catalogue::TransportCatalogue& catalogue, const json::Array& request_info);
 
-    // Получаем информацию из базы (запрос stat_requests)
-    void GetOutputJsonRequest(request_handler::RequestHandler& request_handler, const json::Array& request_info,
-                              [[maybe_unused]] std::ostream& output);
+    // Потоковая загрузка base_requests: запросы декодируются из текста по одному, без дерева JSON.
+    // Остановки добавляются сразу, а расстояния и маршруты откладываются в компактные записи
+    // до конца массива, так как могут ссылаться на остановки, описанные позже
+    void ReadInputJsonRequest(transport_catalogue::TransportCatalogue& catalogue, json::Reader& reader);
+
+    // Изменение справочника запросом UpdateStop: координаты существующей остановки заменяются,
+    // новая остановка добавляется; необязательные road_distances задают расстояния
+    void UpdateStopFromJsonRequest(transport_catalogue::TransportCatalogue& catalogue, const json::Dict& stop_info);
+
+    // Изменение справочника запросом UpdateBus: остановки существующего маршрута заменяются,
+    // новый маршрут добавляется. Неизвестная остановка - std::invalid_argument
+    void UpdateBusFromJsonRequest(transport_catalogue::TransportCatalogue& catalogue, const json::Dict& bus_info);
+
+    // Получаем информацию из базы (запрос stat_requests). Запросы чтения выполняются параллельно по снимкам
+    // справочника, запросы изменения публикуют новые версии (transport_catalogue::SnapshotStore).
+    // Справочник и маршрутизатор не меняются: изменения применяются к копиям
+    void GetOutputJsonRequest(const transport_catalogue::TransportCatalogue& catalogue,
+                              const renderer::MapRenderer& map_renderer,
+                              const transport_router::TransportRouter& router,
+                              const json::Array& request_info, std::ostream& output);
+
+    // Потоковое выполнение stat_requests: запросы читаются по одному и выполняются пачками, ответы
+    // выводятся по готовности пачки, поэтому память не зависит от числа запросов
+    void ReadOutputJsonRequest(const transport_catalogue::TransportCatalogue& catalogue,
+                               const renderer::MapRenderer& map_renderer,
+                               const transport_router::TransportRouter& router,
+                               json::Reader& reader, std::ostream& output);
 
     // Получаем параметры для построения маршрута (запрос routing_settings)
     void GetRouteJsonRequest(transport_router::TransportRouter& router, const json::Dict& request_info);
@@ -0,0 +1,256 @@
+#include "json_writer.h"
+
+#include <array>
+#include <charconv>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+using namespace json;
+using namespace std::literals;
+
+namespace {
+    constexpr size_t INDENT_STEP = 4;
+
+    // Символы, которые Print выводит экранированными
+    constexpr std::array<bool, 256> MakeEscapeTable() {
+        std::array<bool, 256> table{};
+        table[static_cast<unsigned char>('\r')] = true;
+        table[static_cast<unsigned char>('\n')] = true;
+        table[static_cast<unsigned char>('"')] = true;
+        table[static_cast<unsigned char>('\\')] = true;
+        return table;
+    }
+
+    constexpr std::array<bool, 256> ESCAPE_TABLE = MakeEscapeTable();
+}
+
+Writer::Writer(std::ostream& output)
+    : Writer(output, 0) {
+}
+
+Writer::Writer(std::ostream& output, size_t depth)
+    : output_(output)
+    , depth_(depth) {
+    buffer_.reserve(BLOCK_SIZE);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+KeyWriterContext Writer::Key(std::string_view key) {
+    if (scopes_.empty() || scopes_.back() != Scope::DICT || has_key_) {
+        throw std::logic_error("Attempting to set a key to a value outside the map");
+    }
+    if (!is_first_item_) {
+        buffer_ += ",\n"sv;
+    }
+    is_first_item_ = false;
+    WriteIndent(scopes_.size());
+    WriteString(key);
+    buffer_ += ": "sv;
+    has_key_ = true;
+    return {*this};
+}
+
+Writer& Writer::Value(std::nullptr_t) {
+    BeginValue();
+    buffer_ += "null"sv;
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::Value(bool value) {
+    BeginValue();
+    buffer_ += value ? "true"sv : "false"sv;
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::Value(int value) {
+    BeginValue();
+    char text[16];
+    const auto result = std::to_chars(text, text + sizeof(text), value);
+    buffer_.append(text, result.ptr);
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::Value(double value) {
+    BeginValue();
+    // Шесть значащих цифр в кратчайшей из записей - как у std::ostream по умолчанию
+    char text[32];
+    const auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, 6);
+    buffer_.append(text, result.ptr);
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::Value(std::string_view value) {
+    BeginValue();
+    WriteString(value);
+    EndValue();
+    return *this;
+}
+
+Writer& Writer::Value(const std::string& value) {
+    return Value(std::string_view(value));
+}
+
+Writer& Writer::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+
+Writer& Writer::Value(const Node& value) {
+    if (value.IsArray()) {
+        StartArray();
+        for (const Node& item : value.AsArray()) {
+            Value(item);
+        }
+        return EndArray();
+    } else if (value.IsDict()) {
+        StartDict();
+        for (const auto& [key, item] : value.AsDict()) {
+            Key(key);
+            Value(item);
+        }
+        return EndDict();
+    }
+    return std::visit([this](const auto& scalar) -> Writer& {
+        using Scalar = std::decay_t<decltype(scalar)>;
+        if constexpr (std::is_same_v<Scalar, Array> || std::is_same_v<Scalar, Dict>) {
+            return *this;
+        } else {
+            return Value(scalar);
+        }
+    }, value.GetValue());
+}
+
+Writer& Writer::RawValue(std::string_view text) {
+    BeginValue();
+    buffer_ += text;
+    EndValue();
+    return *this;
+}
+
+ArrayWriterContext Writer::StartArray() {
+    BeginValue();
+    buffer_ += "[\n"sv;
+    scopes_.push_back(Scope::ARRAY);
+    is_first_item_ = true;
+    return {*this};
+}
+
+Writer& Writer::EndArray() {
+    if (scopes_.empty() || scopes_.back() != Scope::ARRAY) {
+        throw std::logic_error("Attempting to end an array outside the context");
+    }
+    EndScope(Scope::ARRAY);
+    return *this;
+}
+
+DictWriterContext Writer::StartDict() {
+    BeginValue();
+    buffer_ += "{\n"sv;
+    scopes_.push_back(Scope::DICT);
+    is_first_item_ = true;
+    return {*this};
+}
+
+Writer& Writer::EndDict() {
+    if (scopes_.empty() || scopes_.back() != Scope::DICT || has_key_) {
+        throw std::logic_error("Attempting to end a map outside the context");
+    }
+    EndScope(Scope::DICT);
+    return *this;
+}
+
+void Writer::Flush() {
+    output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void Writer::BeginValue() {
+    if (scopes_.empty()) {
+        if (is_done_) {
+            throw std::logic_error("Attempting to add value outside the context");
+        }
+    } else if (scopes_.back() == Scope::DICT) {
+        if (!has_key_) {
+            throw std::logic_error("Attempting to add value outside the context");
+        }
+        has_key_ = false;
+    } else {
+        if (!is_first_item_) {
+            buffer_ += ",\n"sv;
+        }
+        is_first_item_ = false;
+        WriteIndent(scopes_.size());
+    }
+}
+
+void Writer::EndValue() {
+    if (scopes_.empty()) {
+        is_done_ = true;
+    }
+    if (buffer_.size() >= BLOCK_SIZE) {
+        Flush();
+    }
+}
+
+void Writer::EndScope(Scope scope) {
+    scopes_.pop_back();
+    buffer_ += '\n';
+    WriteIndent(scopes_.size());
+    buffer_ += scope == Scope::ARRAY ? ']' : '}';
+    // Закрытый массив или словарь - элемент внешнего, поэтому тот уже не пуст
+    is_first_item_ = false;
+    EndValue();
+}
+
+void Writer::WriteIndent(size_t depth) {
+    buffer_.append((depth_ + depth) * INDENT_STEP, ' ');
+}
+
+void Writer::WriteString(std::string_view value) {
+    buffer_ += '"';
+    // Участки без экранируемых символов копируются целиком
+    size_t begin = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        const char c = value[i];
+        if (!ESCAPE_TABLE[static_cast<unsigned char>(c)]) {
+            continue;
+        }
+        buffer_.append(value.data() + begin, i - begin);
+        buffer_ += '\\';
+        buffer_ += c == '\r' ? 'r' : c == '\n' ? 'n' : c;
+        begin = i + 1;
+    }
+    buffer_.append(value.data() + begin, value.size() - begin);
+    buffer_ += '"';
+}
+
+// Helper classes methods
+
+KeyWriterContext BaseWriterContext::Key(std::string_view key) {
+    return writer_.Key(key);
+}
+
+ArrayWriterContext BaseWriterContext::StartArray() {
+    return writer_.StartArray();
+}
+
+Writer& BaseWriterContext::EndArray() {
+    return writer_.EndArray();
+}
+
+DictWriterContext BaseWriterContext::StartDict() {
+    return writer_.StartDict();
+}
+
+Writer& BaseWriterContext::EndDict() {
+    return writer_.EndDict();
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "json.h"
+
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+    class KeyWriterContext;
+    class ArrayWriterContext;
+    class DictWriterContext;
+
+    // Потоковая запись JSON без построения дерева: значения сразу форматируются в буфер вывода
+    // в том же виде, что и у Print (отступ 4 пробела), а буфер передаётся в поток блоками.
+    // Интерфейс и проверки контекста те же, что у Builder, но ключи словаря выводятся в порядке вызова
+    // Key, поэтому для совпадения с Print их нужно задавать по алфавиту. Остаток буфера выводится
+    // в Flush или в деструкторе
+    class Writer {
+    public:
+        explicit Writer(std::ostream& output);
+        // Значение, которое будет вставлено через RawValue внутрь depth массивов или словарей:
+        // отступы строк считаются с этой глубины
+        Writer(std::ostream& output, size_t depth);
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        ~Writer();
+
+        KeyWriterContext Key(std::string_view key);
+        Writer& Value(std::nullptr_t);
+        Writer& Value(bool value);
+        Writer& Value(int value);
+        Writer& Value(double value);
+        Writer& Value(std::string_view value);
+        Writer& Value(const std::string& value);
+        Writer& Value(const char* value);
+        Writer& Value(const Node& value);
+        // Готовый текст значения, записанный Writer с глубиной текущего места
+        Writer& RawValue(std::string_view text);
+        ArrayWriterContext StartArray();
+        Writer& EndArray();
+        DictWriterContext StartDict();
+        Writer& EndDict();
+
+        // Передаём накопленный текст в поток
+        void Flush();
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        enum class Scope {
+            ARRAY,
+            DICT,
+        };
+
+        // Разделитель и отступ перед значением; проверяем, что значение здесь допустимо
+        void BeginValue();
+        // Значение записано: корень завершён или буфер пора передать в поток
+        void EndValue();
+        void EndScope(Scope scope);
+        void WriteIndent(size_t depth);
+        void WriteString(std::string_view value);
+
+        std::ostream& output_;
+        size_t depth_ = 0; // Глубина корневого значения
+        std::string buffer_;
+        std::vector<Scope> scopes_;
+        bool is_first_item_ = true; // В текущем массиве или словаре ещё нет элементов
+        bool has_key_ = false; // Ключ словаря записан, ожидается значение
+        bool is_done_ = false; // Корневое значение записано
+    };
+
+    class BaseWriterContext {
+    public:
+        BaseWriterContext(Writer& writer)
+            : writer_(writer) {
+        }
+        KeyWriterContext Key(std::string_view key);
+        ArrayWriterContext StartArray();
+        Writer& EndArray();
+        DictWriterContext StartDict();
+        Writer& EndDict();
+
+    protected:
+        Writer& writer_;
+    };
+
+    class KeyWriterContext : public BaseWriterContext {
+    public:
+        template <typename ValueType>
+        DictWriterContext Value(const ValueType& value);
+    private:
+        KeyWriterContext Key(std::string_view key) = delete;
+        Writer& EndArray() = delete;
+        Writer& EndDict() = delete;
+    };
+
+    class ArrayWriterContext : public BaseWriterContext {
+    public:
+        template <typename ValueType>
+        ArrayWriterContext Value(const ValueType& value);
+    private:
+        KeyWriterContext Key(std::string_view key) = delete;
+        Writer& EndDict() = delete;
+    };
+
+    class DictWriterContext : public BaseWriterContext {
+    private:
+        ArrayWriterContext StartArray() = delete;
+        Writer& EndArray() = delete;
+        DictWriterContext StartDict() = delete;
+    };
+
+    template <typename ValueType>
+    DictWriterContext KeyWriterContext::Value(const ValueType& value) {
+        return {writer_.Value(value)};
+    }
+
+    template <typename ValueType>
+    ArrayWriterContext ArrayWriterContext::Value(const ValueType& value) {
+        return {writer_.Value(value)};
+    }
+}
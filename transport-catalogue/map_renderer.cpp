@@ -1,7 +1,5 @@
 #include "map_renderer.h"
-#include "transport_catalogue.h"
 
-#include <set>
 #include <utility>
 
 using namespace renderer;
@@ -14,15 +12,24 @@ void MapRenderer::SetRenderSettings(const MapRendererSettings& renderer_settings
     map_renderer_ = renderer_settings;
 }
 
-svg::Document MapRenderer::AddRoutesOnMap(const std::map<std::string_view, const Bus*>& all_routes) const {
+svg::Document MapRenderer::AddRoutesOnMap(const transport_catalogue::TransportCatalogue& catalogue) const {
     svg::Document result;
-    auto comparator = [] (const Stop* lhs, const Stop* rhs) {
-        return lhs->name < rhs->name;
-    };
-    std::set<const Stop*, decltype(comparator)> all_stops(comparator);
+    const auto all_routes = catalogue.GetRouteNames();
+    const auto& stop_coordinates = catalogue.GetStopCoordinates();
+    // Остановки, через которые проходят маршруты, отмечаются по номерам и сортируются по названию
+    std::vector<bool> is_route_stop(catalogue.GetStopsCount(), false);
+    std::vector<const Stop*> all_stops;
     for (const auto& [bus_name, bus_info] : all_routes) {
-        all_stops.insert(bus_info->stops.begin(), bus_info->stops.end());
+        for (const StopId stop : bus_info->stops) {
+            if (!is_route_stop[stop]) {
+                is_route_stop[stop] = true;
+                all_stops.push_back(catalogue.GetStop(stop));
+            }
+        }
     }
+    std::sort(all_stops.begin(), all_stops.end(), [] (const Stop* lhs, const Stop* rhs) {
+        return lhs->name < rhs->name;
+    });
     SphereProjector sphere_projector(all_stops.begin(), all_stops.end(),
                                      map_renderer_.width, map_renderer_.height,
                                      map_renderer_.padding);
@@ -31,7 +38,7 @@ svg::Document MapRenderer::AddRoutesOnMap(const std::map<std::string_view, const
         if (bus_info->stops.empty()) {
             continue;
         } else {
-            result.Add(DrawRoutePolyline(bus_info, sphere_projector, route_index));
+            result.Add(DrawRoutePolyline(bus_info, stop_coordinates, sphere_projector, route_index));
             ++route_index;
         }
     }
@@ -40,13 +47,15 @@ svg::Document MapRenderer::AddRoutesOnMap(const std::map<std::string_view, const
         if (bus_info->stops.empty()) {
             continue;
         } else  {
-            result.Add(DrawRouteNameBackground(bus_info->name, bus_info->stops[0], sphere_projector));
-            result.Add(DrawRouteName(bus_info->name, bus_info->stops[0], sphere_projector, route_index));
+            const Stop* first_stop = catalogue.GetStop(bus_info->stops[0]);
+            result.Add(DrawRouteNameBackground(std::string(bus_info->name), first_stop, sphere_projector));
+            result.Add(DrawRouteName(std::string(bus_info->name), first_stop, sphere_projector, route_index));
             if (!(bus_info->is_round_route)) {
                 size_t last_stop = (bus_info->stops.size()) / 2;
                 if (bus_info->stops[last_stop] != bus_info->stops[0]) {
-                    result.Add(DrawRouteNameBackground(bus_info->name, bus_info->stops[last_stop], sphere_projector));
-                    result.Add(DrawRouteName(bus_info->name, bus_info->stops[last_stop], sphere_projector, route_index));
+                    const Stop* end_stop = catalogue.GetStop(bus_info->stops[last_stop]);
+                    result.Add(DrawRouteNameBackground(std::string(bus_info->name), end_stop, sphere_projector));
+                    result.Add(DrawRouteName(std::string(bus_info->name), end_stop, sphere_projector, route_index));
                 }
             }
             ++route_index;
@@ -67,15 +76,16 @@ MapRendererSettings MapRenderer::GetSettings() const {
     return map_renderer_;
 }
 
-svg::Polyline MapRenderer::DrawRoutePolyline(const Bus* bus_info, SphereProjector& sphere_projector, int route_index) const {
+svg::Polyline MapRenderer::DrawRoutePolyline(const Bus* bus_info, const std::vector<geo::Coordinates>& stop_coordinates,
+                                             SphereProjector& sphere_projector, int route_index) const {
     svg::Polyline route_polyline;
     route_polyline.SetFillColor("none"s);
     route_polyline.SetStrokeColor(map_renderer_.color_palette[route_index % map_renderer_.color_palette.size()]);
     route_polyline.SetStrokeWidth(map_renderer_.line_width);
     route_polyline.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
     route_polyline.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-    for (const auto& stop : bus_info->stops) {
-        route_polyline.AddPoint(sphere_projector(stop->coordinates));
+    for (const StopId stop : bus_info->stops) {
+        route_polyline.AddPoint(sphere_projector(stop_coordinates[stop]));
     }
     return route_polyline;
 }
@@ -122,7 +132,7 @@ svg::Text MapRenderer::DrawStopNameBackground(const Stop* stop_info, SphereProje
     stop_name_background.SetOffset(map_renderer_.stop_label_offset);
     stop_name_background.SetFontSize(map_renderer_.stop_label_font_size);
     stop_name_background.SetFontFamily("Verdana");
-    stop_name_background.SetData(stop_info->name);
+    stop_name_background.SetData(std::string(stop_info->name));
     stop_name_background.SetFillColor(map_renderer_.underlayer_color);
     stop_name_background.SetStrokeColor(map_renderer_.underlayer_color);
     stop_name_background.SetStrokeWidth(map_renderer_.underlayer_width);
@@ -137,7 +147,7 @@ svg::Text MapRenderer::DrawStopName(const Stop* stop_info, SphereProjector& sphe
     stop_name.SetOffset(map_renderer_.stop_label_offset);
     stop_name.SetFontSize(map_renderer_.stop_label_font_size);
     stop_name.SetFontFamily("Verdana");
-    stop_name.SetData(stop_info->name);
+    stop_name.SetData(std::string(stop_info->name));
     stop_name.SetFillColor("black");
     return stop_name;
 }
\ No newline at end of file
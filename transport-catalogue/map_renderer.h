@@ -3,6 +3,7 @@
 #include "geo.h"
 #include "svg.h"
 #include "domain.h"
+#include "transport_catalogue.h"
 
 #include <algorithm>
 #include <cstdlib>
@@ -103,13 +104,14 @@ namespace renderer {
         MapRenderer() = default;
 
         void SetRenderSettings(const MapRendererSettings& renderer_settings);
-        svg::Document AddRoutesOnMap(const std::map<std::string_view, const Bus*>& all_routes) const;
+        svg::Document AddRoutesOnMap(const transport_catalogue::TransportCatalogue& catalogue) const;
         MapRendererSettings GetSettings() const;
 
     private:
         MapRendererSettings map_renderer_;
 
-        svg::Polyline DrawRoutePolyline(const Bus* bus_info, SphereProjector& sphere_projector, int route_index) const;
+        svg::Polyline DrawRoutePolyline(const Bus* bus_info, const std::vector<geo::Coordinates>& stop_coordinates,
+                                        SphereProjector& sphere_projector, int route_index) const;
         svg::Text DrawRouteName(std::string bus_name, const Stop* stop_info, SphereProjector& sphere_projector, int route_index) const;
         svg::Text DrawRouteNameBackground(std::string bus_name, const Stop* stop_info, SphereProjector& sphere_projector) const;
         svg::Circle DrawStopSign(const Stop* stop_info, SphereProjector& sphere_projector) const;
@@ -0,0 +1,237 @@
+#include "name_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace transport_catalogue {
+    namespace {
+        uint64_t Mix(uint64_t value) {
+            value ^= value >> 30;
+            value *= 0xbf58476d1ce4e5b9ULL;
+            value ^= value >> 27;
+            value *= 0x94d049bb133111ebULL;
+            return value ^ (value >> 31);
+        }
+
+        uint64_t MixWithSeed(uint64_t hash, uint32_t seed) {
+            return Mix(hash ^ (seed * 0x9e3779b97f4a7c15ULL));
+        }
+
+        // Средний размер корзины совершенной хэш-функции
+        const size_t KEYS_PER_BUCKET = 3;
+    }
+
+    NameArena::NameArena(const NameArena& other)
+        : blocks_(other.blocks_)
+        , names_(other.names_)
+        , table_(other.table_)
+        , count_(other.count_)
+        , perfect_hash_(other.perfect_hash_) {
+        // Свободное место последнего блока может занять оригинал, поэтому копия начинает новый блок
+    }
+
+    NameArena& NameArena::operator=(const NameArena& other) {
+        if (this != &other) {
+            *this = NameArena(other);
+        }
+        return *this;
+    }
+
+    std::string_view NameArena::Add(std::string_view name, uint32_t id) {
+        if (!perfect_hash_.slots.empty()) {
+            const std::string_view stored = Store(name);
+            if (id >= names_.size()) {
+                names_.resize(id + 1);
+            }
+            names_[id] = stored;
+            if (perfect_hash_.slots[GetPerfectSlot(Hash(name))] != id) {
+                RebuildTable();
+            }
+            return stored;
+        }
+        // Заполненность таблицы не больше половины
+        if ((count_ + 1) * 2 > table_.size()) {
+            Rehash();
+        }
+        const uint32_t hash = static_cast<uint32_t>(Hash(name));
+        Handle& handle = table_[FindSlot(name, hash)];
+        std::string_view stored = handle.id != NO_ID ? names_[handle.id] : Store(name);
+        if (handle.id == NO_ID) {
+            ++count_;
+        }
+        handle = {hash, id};
+        if (id >= names_.size()) {
+            names_.resize(id + 1);
+        }
+        names_[id] = stored;
+        return stored;
+    }
+
+    uint32_t NameArena::Find(std::string_view name) const {
+        if (!perfect_hash_.slots.empty()) {
+            const uint32_t id = perfect_hash_.slots[GetPerfectSlot(Hash(name))];
+            return id < names_.size() && names_[id] == name ? id : NO_ID;
+        }
+        if (table_.empty()) {
+            return NO_ID;
+        }
+        return table_[FindSlot(name, static_cast<uint32_t>(Hash(name)))].id;
+    }
+
+    void NameArena::BuildPerfectHash() {
+        std::vector<std::pair<uint64_t, uint32_t>> keys; // хэш и номер каждого названия
+        keys.reserve(count_);
+        for (const Handle& handle : table_) {
+            if (handle.id != NO_ID) {
+                keys.emplace_back(Hash(names_[handle.id]), handle.id);
+            }
+        }
+        if (keys.empty()) {
+            return;
+        }
+        const size_t key_count = keys.size();
+        const size_t bucket_count = key_count / KEYS_PER_BUCKET + 1;
+        std::vector<std::vector<size_t>> buckets(bucket_count);
+        for (size_t key = 0; key < key_count; ++key) {
+            buckets[keys[key].first % bucket_count].push_back(key);
+        }
+        // Большие корзины размещаются первыми, пока свободных позиций много
+        std::vector<size_t> bucket_order(bucket_count);
+        for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            bucket_order[bucket] = bucket;
+        }
+        std::stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](size_t lhs, size_t rhs) {
+            return buckets[lhs].size() > buckets[rhs].size();
+        });
+
+        PerfectHash perfect_hash{std::vector<uint32_t>(bucket_count, 0), std::vector<uint32_t>(key_count, NO_ID)};
+        std::vector<size_t> positions;
+        for (const size_t bucket : bucket_order) {
+            const auto& bucket_keys = buckets[bucket];
+            if (bucket_keys.empty()) {
+                break;
+            }
+            for (uint32_t seed = 0; ; ++seed) {
+                if (seed == std::numeric_limits<uint32_t>::max()) {
+                    throw std::runtime_error("Failed to build perfect hash of names");
+                }
+                positions.clear();
+                bool placed = true;
+                for (const size_t key : bucket_keys) {
+                    const size_t position = MixWithSeed(keys[key].first, seed) % key_count;
+                    if (perfect_hash.slots[position] != NO_ID
+                        || std::find(positions.begin(), positions.end(), position) != positions.end()) {
+                        placed = false;
+                        break;
+                    }
+                    positions.push_back(position);
+                }
+                if (placed) {
+                    perfect_hash.seeds[bucket] = seed;
+                    for (size_t i = 0; i < bucket_keys.size(); ++i) {
+                        perfect_hash.slots[positions[i]] = keys[bucket_keys[i]].second;
+                    }
+                    break;
+                }
+            }
+        }
+        SetPerfectHash(std::move(perfect_hash));
+    }
+
+    void NameArena::SetPerfectHash(PerfectHash perfect_hash) {
+        perfect_hash_ = std::move(perfect_hash);
+        if (perfect_hash_.seeds.empty() || perfect_hash_.slots.empty()) {
+            perfect_hash_ = {};
+        }
+        if (!perfect_hash_.slots.empty()) {
+            table_.clear();
+            table_.shrink_to_fit();
+            count_ = 0;
+        }
+    }
+
+    const NameArena::PerfectHash& NameArena::GetPerfectHash() const {
+        return perfect_hash_;
+    }
+
+    uint64_t NameArena::Hash(std::string_view name) {
+        // FNV-1a с перемешиванием результата
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const char c : name) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+        }
+        return Mix(hash);
+    }
+
+    uint32_t NameArena::GetPerfectSlot(uint64_t hash) const {
+        const uint32_t seed = perfect_hash_.seeds[hash % perfect_hash_.seeds.size()];
+        return static_cast<uint32_t>(MixWithSeed(hash, seed) % perfect_hash_.slots.size());
+    }
+
+    size_t NameArena::FindSlot(std::string_view name, uint32_t hash) const {
+        const size_t mask = table_.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            const Handle& handle = table_[slot];
+            if (handle.id == NO_ID || (handle.hash == hash && names_[handle.id] == name)) {
+                return slot;
+            }
+        }
+    }
+
+    std::string_view NameArena::Store(std::string_view name) {
+        if (name.empty()) {
+            // Непустой указатель отличает пустое название от номера без названия
+            return std::string_view("", 0);
+        }
+        if (name.size() > BLOCK_SIZE / 4) {
+            // Длинное название получает собственный блок; он ставится в начало, чтобы последним
+            // оставался заполняемый блок
+            std::shared_ptr<char[]> block(new char[name.size()]);
+            std::memcpy(block.get(), name.data(), name.size());
+            const std::string_view stored(block.get(), name.size());
+            blocks_.insert(blocks_.begin(), std::move(block));
+            return stored;
+        }
+        if (name.size() > BLOCK_SIZE - block_used_) {
+            blocks_.emplace_back(new char[BLOCK_SIZE]);
+            block_used_ = 0;
+        }
+        char* data = blocks_.back().get() + block_used_;
+        std::memcpy(data, name.data(), name.size());
+        block_used_ += name.size();
+        return {data, name.size()};
+    }
+
+    void NameArena::Rehash() {
+        std::vector<Handle> old_table(std::max<size_t>(table_.size() * 2, 16));
+        old_table.swap(table_);
+        for (const Handle& handle : old_table) {
+            if (handle.id != NO_ID) {
+                Handle& slot = table_[FindSlot(names_[handle.id], handle.hash)];
+                slot = handle;
+            }
+        }
+    }
+
+    void NameArena::RebuildTable() {
+        perfect_hash_ = {};
+        table_.clear();
+        count_ = 0;
+        // Названия по возрастанию номеров: при повторах остаётся последний номер, как при обычном добавлении
+        for (uint32_t id = 0; id < names_.size(); ++id) {
+            if (names_[id].data() == nullptr) {
+                continue;
+            }
+            if ((count_ + 1) * 2 > table_.size()) {
+                Rehash();
+            }
+            const uint32_t hash = static_cast<uint32_t>(Hash(names_[id]));
+            Handle& handle = table_[FindSlot(names_[id], hash)];
+            if (handle.id == NO_ID) {
+                ++count_;
+            }
+            handle = {hash, id};
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+    // Хранилище названий: строки упаковываются подряд в крупные блоки вместо отдельной строки на каждое название.
+    // Номер названия ищется одним из двух индексов:
+    // - при наполнении - хэш-таблицей с открытой адресацией из пар хэша и номера, строки сравниваются
+    //   только при совпадении хэшей;
+    // - после BuildPerfectHash или SetPerfectHash - минимальной совершенной хэш-функцией: одно вычисление
+    //   хэша и одно сравнение строк на поиск.
+    // Поиск принимает std::string_view и не создаёт временных строк. Представления названий остаются
+    // действительными, пока жив блок: копия хранилища разделяет блоки с оригиналом, а новые
+    // названия копия записывает в свой блок
+    class NameArena {
+    public:
+        static constexpr uint32_t NO_ID = std::numeric_limits<uint32_t>::max();
+
+        // Минимальная совершенная хэш-функция (hash and displace): хэш названия выбирает корзину,
+        // значение корзины перемешивается с хэшем и даёт позицию, позиция хранит номер названия.
+        // Хэш не зависит от реализации стандартной библиотеки, поэтому функцию можно сохранить в базе
+        struct PerfectHash {
+            std::vector<uint32_t> seeds; // значения корзин
+            std::vector<uint32_t> slots; // номера названий по позициям
+        };
+
+        NameArena() = default;
+        NameArena(const NameArena& other);
+        NameArena& operator=(const NameArena& other);
+        NameArena(NameArena&&) = default;
+        NameArena& operator=(NameArena&&) = default;
+
+        // Сохраняем название под номером id и возвращаем его копию в хранилище.
+        // Если название уже есть, ему назначается новый номер. Название, которого нет в совершенной
+        // хэш-функции, возвращает хранилище к хэш-таблице
+        std::string_view Add(std::string_view name, uint32_t id);
+
+        // Номер названия или NO_ID, если его нет
+        uint32_t Find(std::string_view name) const;
+
+        // Строим совершенную хэш-функцию по добавленным названиям вместо хэш-таблицы
+        void BuildPerfectHash();
+
+        // Устанавливаем ранее построенную функцию; названия с её номерами добавляются после этого без индексации
+        void SetPerfectHash(PerfectHash perfect_hash);
+
+        // Пустая, если функция не построена
+        const PerfectHash& GetPerfectHash() const;
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        struct Handle {
+            uint32_t hash = 0;
+            uint32_t id = NO_ID;
+        };
+
+        static uint64_t Hash(std::string_view name);
+        uint32_t GetPerfectSlot(uint64_t hash) const;
+
+        // Позиция записи с этим названием или первой свободной записи
+        size_t FindSlot(std::string_view name, uint32_t hash) const;
+        std::string_view Store(std::string_view name);
+        void Rehash();
+        // Переходим от совершенной хэш-функции к хэш-таблице по всем названиям
+        void RebuildTable();
+
+        std::vector<std::shared_ptr<char[]>> blocks_; // Блоки с символами названий, общие с копиями
+        size_t block_used_ = BLOCK_SIZE; // Занято в последнем блоке
+        std::vector<std::string_view> names_; // Названия по номерам
+        std::vector<Handle> table_; // Хэш-таблица, размер - степень двойки
+        size_t count_ = 0; // Число названий в таблице
+        PerfectHash perfect_hash_; // Совершенная хэш-функция, если построена
+    };
+
+}  // namespace transport_catalogue
@@ -22,6 +22,9 @@ namespace ranges {
         It end() const {
             return end_;
         }
+        bool empty() const {
+            return begin_ == end_;
+        }
 
     private:
         It begin_;
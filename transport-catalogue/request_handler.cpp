@@ -1,5 +1,7 @@
 #include "request_handler.h"
 
+#include <algorithm>
+
 namespace request_handler {
     std::optional<BusInfo> RequestHandler::GetBusStat(const std::string_view& bus_name) const {
         const Bus* bus = catalogue_.FindBus(bus_name);
@@ -28,11 +30,48 @@ namespace request_handler {
     }
 
     svg::Document RequestHandler::RenderMap() const {
-        return renderer_.AddRoutesOnMap(catalogue_.GetRouteNames());
+        return renderer_.AddRoutesOnMap(catalogue_);
     }
 
     RequestHandler::RouteInfo RequestHandler::GetRouteInfo(const std::string_view from,
                                                            const std::string_view to) const {
         return router_.GetRouteInfo(catalogue_.FindStop(from), catalogue_.FindStop(to));
     }
+
+    RequestHandler::RouteInfo RequestHandler::GetRouteInfo(
+            const std::string_view from, const std::string_view to,
+            const transport_router::TransportRouter::RouteSettings& profile) const {
+        return router_.GetRouteInfo(catalogue_.FindStop(from), catalogue_.FindStop(to), profile);
+    }
+
+    transport_router::TransportRouter::RouteSettings RequestHandler::GetRouteSettings() const {
+        return router_.GetSettings();
+    }
+
+    RequestHandler::TimeMatrix RequestHandler::GetTimeMatrix(const std::vector<std::string_view>& from,
+                                                             const std::vector<std::string_view>& to) const {
+        auto find_stops = [this](const std::vector<std::string_view>& stop_names) {
+            std::vector<const Stop*> stops;
+            stops.reserve(stop_names.size());
+            for (const auto stop_name : stop_names) {
+                stops.push_back(catalogue_.FindStop(stop_name));
+            }
+            return stops;
+        };
+        const std::vector<const Stop*> from_stops = find_stops(from);
+        const std::vector<const Stop*> to_stops = find_stops(to);
+        auto is_unknown = [](const Stop* stop) {
+            return stop == nullptr;
+        };
+        if (std::any_of(from_stops.begin(), from_stops.end(), is_unknown)
+            || std::any_of(to_stops.begin(), to_stops.end(), is_unknown)) {
+            return {};
+        }
+        return router_.GetTimeMatrix(from_stops, to_stops);
+    }
+
+    std::vector<NearbyStop> RequestHandler::GetNearestStops(const geo::Coordinates& point, size_t count,
+                                                            double max_distance) const {
+        return catalogue_.FindNearestStops(point, count, max_distance);
+    }
 }
\ No newline at end of file
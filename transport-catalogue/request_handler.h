@@ -31,6 +31,20 @@ namespace request_handler {
 
         using RouteInfo = std::optional<transport_router::TransportRouter::RouteInfo>;
         RouteInfo GetRouteInfo(const std::string_view start, const std::string_view stop) const;
+        // Маршрут с собственными скоростью автобуса и временем ожидания
+        RouteInfo GetRouteInfo(const std::string_view start, const std::string_view stop,
+                               const transport_router::TransportRouter::RouteSettings& profile) const;
+        // Настройки маршрутизатора, заданные при построении базы
+        transport_router::TransportRouter::RouteSettings GetRouteSettings() const;
+
+        // Возвращает матрицу времени в пути (запрос RouteMatrix), если все остановки известны
+        using TimeMatrix = std::optional<transport_router::TransportRouter::TimeMatrix>;
+        TimeMatrix GetTimeMatrix(const std::vector<std::string_view>& from,
+                                 const std::vector<std::string_view>& to) const;
+
+        // Ближайшие к точке остановки (запрос NearestStops): не более count в радиусе max_distance метров
+        std::vector<NearbyStop> GetNearestStops(const geo::Coordinates& point, size_t count,
+                                                double max_distance) const;
 
     private:
         // RequestHandler использует агрегацию объектов "Транспортный Справочник", "Визуализатор Карты"
@@ -3,115 +3,324 @@
 #include "graph.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
+    namespace detail {
+        // Пул потоков для независимых задач одной фазы вычислений.
+        // Run() раздаёт номера задач потокам пула и вызывающему потоку и возвращает управление,
+        // когда выполнены все задачи. Если задача бросила исключение, оставшиеся задачи не раздаются,
+        // Run() дожидается всех потоков и бросает первое исключение
+        class ThreadPool {
+        public:
+            explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency()) {
+                for (size_t i = 1; i < thread_count; ++i) {
+                    workers_.emplace_back([this] { WorkerLoop(); });
+                }
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            ~ThreadPool() {
+                {
+                    std::lock_guard lock(mutex_);
+                    stop_ = true;
+                }
+                start_cv_.notify_all();
+                for (auto& worker : workers_) {
+                    worker.join();
+                }
+            }
+
+            size_t GetThreadCount() const {
+                return workers_.size() + 1;
+            }
+
+            void Run(size_t task_count, const std::function<void(size_t)>& task) {
+                if (workers_.empty() || task_count <= 1) {
+                    for (size_t task_id = 0; task_id < task_count; ++task_id) {
+                        task(task_id);
+                    }
+                    return;
+                }
+                {
+                    std::lock_guard lock(mutex_);
+                    task_ = &task;
+                    task_count_ = task_count;
+                    next_task_ = 0;
+                    busy_workers_ = workers_.size();
+                    ++generation_;
+                }
+                start_cv_.notify_all();
+                ExecuteTasks();
+                std::unique_lock lock(mutex_);
+                done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+                task_ = nullptr;
+                if (error_) {
+                    std::rethrow_exception(std::exchange(error_, nullptr));
+                }
+            }
+
+        private:
+            void ExecuteTasks() {
+                for (size_t task_id = next_task_++; task_id < task_count_; task_id = next_task_++) {
+                    try {
+                        (*task_)(task_id);
+                    } catch (...) {
+                        std::lock_guard lock(mutex_);
+                        if (!error_) {
+                            error_ = std::current_exception();
+                        }
+                        next_task_ = task_count_;
+                    }
+                }
+            }
+
+            void WorkerLoop() {
+                size_t seen_generation = 0;
+                while (true) {
+                    {
+                        std::unique_lock lock(mutex_);
+                        start_cv_.wait(lock, [this, seen_generation] {
+                            return stop_ || generation_ != seen_generation;
+                        });
+                        if (stop_) {
+                            return;
+                        }
+                        seen_generation = generation_;
+                    }
+                    ExecuteTasks();
+                    std::lock_guard lock(mutex_);
+                    if (--busy_workers_ == 0) {
+                        done_cv_.notify_one();
+                    }
+                }
+            }
+
+            std::vector<std::thread> workers_;
+            std::mutex mutex_;
+            std::condition_variable start_cv_;
+            std::condition_variable done_cv_;
+            const std::function<void(size_t)>* task_ = nullptr;
+            size_t task_count_ = 0;
+            std::atomic<size_t> next_task_ = 0;
+            size_t busy_workers_ = 0;
+            size_t generation_ = 0;
+            bool stop_ = false;
+            std::exception_ptr error_; // Первое исключение задач текущего Run()
+        };
+    }  // namespace detail
+
+    // Общий интерфейс маршрутизаторов: движки отличаются только способом поиска кратчайшего пути
     template <typename Weight>
-    class Router {
+    class BaseRouter {
+    public:
+        struct RouteInfo {
+            Weight weight;
+            std::vector<EdgeId> edges;
+        };
+
+        virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+        virtual ~BaseRouter() = default;
+    };
+
+    // Хранилище таблиц маршрутизатора всех пар вершин: две непрерывные матрицы V x V по строкам
+    // (структура массивов). Вместо std::optional используются значения-метки, поэтому ячейка занимает
+    // sizeof(StoredWeight) + sizeof(StoredEdgeId) байт: 16 для double/size_t и 8 для float/uint32_t
+    template <typename StoredWeight, typename StoredEdgeId>
+    struct RoutesTable {
+        static constexpr StoredWeight NO_ROUTE = std::numeric_limits<StoredWeight>::has_infinity
+                                                 ? std::numeric_limits<StoredWeight>::infinity()
+                                                 : std::numeric_limits<StoredWeight>::max();
+        static constexpr StoredEdgeId NO_EDGE = std::numeric_limits<StoredEdgeId>::max();
+
+        std::vector<StoredWeight> weights; // NO_ROUTE, если пути нет
+        std::vector<StoredEdgeId> prev_edges; // последнее ребро пути; NO_EDGE для пустого пути
+    };
+
+    // Маршрутизатор с предрасчётом всех пар вершин (алгоритм Флойда-Уоршелла).
+    // Расчёт идёт блоками BLOCK_SIZE x BLOCK_SIZE: на каждой фазе сначала обновляется диагональный блок,
+    // затем блоки его строки и столбца, затем все остальные; блоки внутри второй и третьей стадий
+    // независимы и считаются параллельно в пуле потоков.
+    // StoredWeight и StoredEdgeId задают типы ячеек таблиц: Router<double, float, uint32_t> занимает
+    // вдвое меньше памяти ценой точности весов (около 7 значащих цифр) и ограничения на число рёбер
+    template <typename Weight, typename StoredWeight = Weight, typename StoredEdgeId = EdgeId>
+    class Router final : public BaseRouter<Weight> {
     private:
         using Graph = DirectedWeightedGraph<Weight>;
 
     public:
+        using RouteInfo = typename BaseRouter<Weight>::RouteInfo;
+        using RoutesInternalData = RoutesTable<StoredWeight, StoredEdgeId>;
+
+        static constexpr StoredWeight NO_ROUTE = RoutesInternalData::NO_ROUTE;
+        static constexpr StoredEdgeId NO_EDGE = RoutesInternalData::NO_EDGE;
+
         explicit Router(const Graph& graph);
+        // Восстановление ранее рассчитанных таблиц маршрутов без повторного расчёта
+        Router(const Graph& graph, RoutesInternalData routes_internal_data);
 
-        struct RouteInfo {
-            Weight weight;
-            std::vector<EdgeId> edges;
-        };
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
 
-        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        const RoutesInternalData& GetRoutesInternalData() const {
+            return routes_internal_data_;
+        }
 
     private:
-        struct RouteInternalData {
-            Weight weight;
-            std::optional<EdgeId> prev_edge;
-        };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+        static constexpr size_t BLOCK_SIZE = 64;
 
         void InitializeRoutesInternalData(const Graph& graph) {
-            const size_t vertex_count = graph.GetVertexCount();
-            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            if (graph.GetEdgeCount() >= static_cast<size_t>(NO_EDGE)) {
+                throw std::length_error("Too many edges for the route table edge id type");
+            }
+            auto& [weights, prev_edges] = routes_internal_data_;
+            for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+                weights[vertex * vertex_count_ + vertex] = StoredWeight{};
                 for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                     const auto& edge = graph.GetEdge(edge_id);
                     if (edge.weight < ZERO_WEIGHT) {
                         throw std::domain_error("Edges' weights should be non-negative");
                     }
-                    auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                    if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                        route_internal_data = RouteInternalData{edge.weight, edge_id};
+                    const size_t cell = vertex * vertex_count_ + edge.to;
+                    const auto edge_weight = static_cast<StoredWeight>(edge.weight);
+                    if (weights[cell] > edge_weight) {
+                        weights[cell] = edge_weight;
+                        prev_edges[cell] = static_cast<StoredEdgeId>(edge_id);
                     }
                 }
             }
         }
 
-        void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                        const RouteInternalData& route_to) {
-            auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-            const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-                route_relaxing = {candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+        // Улучшаем пути блока (block_from, block_to) через вершины блока block_through
+        void RelaxBlock(size_t block_from, size_t block_to, size_t block_through) {
+            auto& [weights, prev_edges] = routes_internal_data_;
+            const size_t from_end = std::min(vertex_count_, (block_from + 1) * BLOCK_SIZE);
+            const size_t to_begin = block_to * BLOCK_SIZE;
+            const size_t to_end = std::min(vertex_count_, to_begin + BLOCK_SIZE);
+            const size_t through_end = std::min(vertex_count_, (block_through + 1) * BLOCK_SIZE);
+            for (VertexId through = block_through * BLOCK_SIZE; through < through_end; ++through) {
+                const StoredWeight* through_row = weights.data() + through * vertex_count_;
+                const StoredEdgeId* through_prev_row = prev_edges.data() + through * vertex_count_;
+                for (VertexId from = block_from * BLOCK_SIZE; from < from_end; ++from) {
+                    StoredWeight* from_row = weights.data() + from * vertex_count_;
+                    StoredEdgeId* from_prev_row = prev_edges.data() + from * vertex_count_;
+                    const StoredWeight weight_from = from_row[through];
+                    if (weight_from == NO_ROUTE) {
+                        continue;
+                    }
+                    for (VertexId to = to_begin; to < to_end; ++to) {
+                        if constexpr (!std::numeric_limits<StoredWeight>::has_infinity) {
+                            if (through_row[to] == NO_ROUTE) {
+                                continue;
+                            }
+                        }
+                        // Путь через through заканчивается тем же ребром, что и путь through -> to.
+                        // Запись без ветвления позволяет компилятору векторизовать цикл
+                        const StoredWeight candidate_weight = weight_from + through_row[to];
+                        const StoredEdgeId candidate_prev_edge = through_prev_row[to];
+                        const bool is_better = candidate_weight < from_row[to];
+                        from_row[to] = is_better ? candidate_weight : from_row[to];
+                        from_prev_row[to] = is_better ? candidate_prev_edge : from_prev_row[to];
+                    }
+                }
             }
         }
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+        void ComputeRoutesInternalData() {
+            const size_t block_count = (vertex_count_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            detail::ThreadPool pool(block_count > 1 ? std::thread::hardware_concurrency() : 1);
+            for (size_t block_through = 0; block_through < block_count; ++block_through) {
+                RelaxBlock(block_through, block_through, block_through);
+                // Блоки строки и столбца опорного блока
+                pool.Run(2 * block_count, [this, block_count, block_through](size_t task_id) {
+                    const size_t block = task_id % block_count;
+                    if (block == block_through) {
+                        return;
+                    }
+                    if (task_id < block_count) {
+                        RelaxBlock(block_through, block, block_through);
+                    } else {
+                        RelaxBlock(block, block_through, block_through);
+                    }
+                });
+                // Остальные блоки, по одной строке блоков на задачу
+                pool.Run(block_count, [this, block_count, block_through](size_t block_from) {
+                    if (block_from == block_through) {
+                        return;
+                    }
+                    for (size_t block_to = 0; block_to < block_count; ++block_to) {
+                        if (block_to != block_through) {
+                            RelaxBlock(block_from, block_to, block_through);
                         }
                     }
-                }
+                });
             }
         }
 
         static constexpr Weight ZERO_WEIGHT{};
         const Graph& graph_;
+        size_t vertex_count_;
         RoutesInternalData routes_internal_data_;
     };
 
-    template <typename Weight>
-    Router<Weight>::Router(const Graph& graph)
+    template <typename Weight, typename StoredWeight, typename StoredEdgeId>
+    Router<Weight, StoredWeight, StoredEdgeId>::Router(const Graph& graph)
             : graph_(graph)
-            , routes_internal_data_(graph.GetVertexCount(),
-                                    std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+            , vertex_count_(graph.GetVertexCount())
+            , routes_internal_data_{std::vector<StoredWeight>(vertex_count_ * vertex_count_, NO_ROUTE),
+                                    std::vector<StoredEdgeId>(vertex_count_ * vertex_count_, NO_EDGE)}
     {
         InitializeRoutesInternalData(graph);
+        ComputeRoutesInternalData();
+    }
 
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    template <typename Weight, typename StoredWeight, typename StoredEdgeId>
+    Router<Weight, StoredWeight, StoredEdgeId>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
+            : graph_(graph)
+            , vertex_count_(graph.GetVertexCount())
+            , routes_internal_data_(std::move(routes_internal_data))
+    {
+        if (routes_internal_data_.weights.size() != vertex_count_ * vertex_count_
+            || routes_internal_data_.prev_edges.size() != vertex_count_ * vertex_count_) {
+            throw std::invalid_argument("Routes internal data doesn't match the graph");
         }
     }
 
-    template <typename Weight>
-    std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                                 VertexId to) const {
-        const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-        if (!route_internal_data) {
+    template <typename Weight, typename StoredWeight, typename StoredEdgeId>
+    std::optional<typename Router<Weight, StoredWeight, StoredEdgeId>::RouteInfo>
+    Router<Weight, StoredWeight, StoredEdgeId>::BuildRoute(VertexId from, VertexId to) const {
+        if (from >= vertex_count_ || to >= vertex_count_) {
+            throw std::out_of_range("Vertex is out of graph");
+        }
+        const StoredWeight* weights_from = routes_internal_data_.weights.data() + from * vertex_count_;
+        const StoredEdgeId* prev_edges_from = routes_internal_data_.prev_edges.data() + from * vertex_count_;
+        if (weights_from[to] == NO_ROUTE) {
             return std::nullopt;
         }
-        const Weight weight = route_internal_data->weight;
         std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-             edge_id;
-             edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
-        {
-            edges.push_back(*edge_id);
+        for (StoredEdgeId edge_id = prev_edges_from[to]; edge_id != NO_EDGE;
+             edge_id = prev_edges_from[graph_.GetEdge(edge_id).from]) {
+            edges.push_back(edge_id);
         }
         std::reverse(edges.begin(), edges.end());
 
-        return RouteInfo{weight, std::move(edges)};
+        return RouteInfo{static_cast<Weight>(weights_from[to]), std::move(edges)};
     }
 
 }  // namespace graph
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <limits>
 
 #include "serialization.h"
 #include "domain.h"
@@ -12,19 +13,25 @@ void Serializer::SetSetting(const std::string &file_name) {
 void Serializer::SerializeToFile() {
     std::ofstream output(file_name_, std::ios::binary);
     ProtoCatalogue serialize_catalogue;
-    const auto& all_stops = transport_catalogue_.GetStopNames();
-    for (const auto& [stop_name, stop_ptr] : all_stops) {
-        (*serialize_catalogue.mutable_stops())[reinterpret_cast<uint64_t>(stop_ptr)] = std::move(GetSerializeStop(stop_ptr));
+    *serialize_catalogue.mutable_geo_settings() = GetSerializeGeoSettings(transport_catalogue_.GetGeoSettings());
+    // Остановки и маршруты записываются в порядке номеров, поэтому при загрузке номера сохраняются
+    for (StopId stop_id = 0; stop_id < transport_catalogue_.GetStopsCount(); ++stop_id) {
+        *serialize_catalogue.add_stops() = std::move(GetSerializeStop(transport_catalogue_.GetStop(stop_id)));
     }
-    for (const auto& [bus_name, bus_ptr] : transport_catalogue_.GetRouteNames()) {
-        *serialize_catalogue.add_buses() = std::move(GetSerializeBus(bus_ptr));
+    for (BusId bus_id = 0; bus_id < transport_catalogue_.GetBusesCount(); ++bus_id) {
+        *serialize_catalogue.add_buses() = std::move(GetSerializeBus(transport_catalogue_.GetBus(bus_id)));
     }
-    for (const auto& [pair_from_to, distance] : transport_catalogue_.GetAllDistances()) {
-        *serialize_catalogue.add_distances() = std::move(GetSerializeDistance(pair_from_to.first,
-                                                                              pair_from_to.second, distance));
+    *serialize_catalogue.mutable_stop_names() = GetSerializeNameIndex(transport_catalogue_.GetStopNameIndex());
+    *serialize_catalogue.mutable_bus_names() = GetSerializeNameIndex(transport_catalogue_.GetBusNameIndex());
+    for (const StopId stop_id : transport_catalogue_.GetSpatialIndex().GetOrder()) {
+        serialize_catalogue.add_stop_index(stop_id);
     }
+    transport_catalogue_.GetAllDistances().ForEach([this, &serialize_catalogue](StopId from, StopId to, int distance) {
+        *serialize_catalogue.add_distances() = GetSerializeDistance(from, to, distance);
+    });
     *serialize_catalogue.mutable_render_settings() = GetSerializeRenderSettings(map_renderer_.GetSettings());
     *serialize_catalogue.mutable_router_settings() = GetSerializeRouterSettings(router_.GetSettings());
+    *serialize_catalogue.mutable_router_data() = GetSerializeRouterData();
     serialize_catalogue.SerializeToOstream(&output);
 }
 
@@ -34,70 +41,111 @@ void Serializer::DeserializeFromFile() {
     if (!proto_trans_catalogue.ParseFromIstream(&input)) {
         std::cerr << "Error in deserialize" << std::endl;
     } else {
-        for (const auto& [stop_id, stop] : proto_trans_catalogue.stops()) {
+        transport_catalogue_.SetGeoSettings(GetDeserializeGeoSettings(proto_trans_catalogue.geo_settings()));
+        // Совершенные хэш-функции названий устанавливаются до добавления данных
+        transport_catalogue_.SetNameIndexes(GetDeserializeNameIndex(proto_trans_catalogue.stop_names()),
+                                            GetDeserializeNameIndex(proto_trans_catalogue.bus_names()));
+        for (const auto& stop : proto_trans_catalogue.stops()) {
             transport_catalogue_.AddStop(GetDeserializeStop(stop));
         }
-        for (const auto& bus : proto_trans_catalogue.buses()) {
-            transport_catalogue_.AddBus(GetDeserializeBus(bus, proto_trans_catalogue));
+        if (proto_trans_catalogue.stop_index_size() == proto_trans_catalogue.stops_size()) {
+            transport_catalogue_.SetSpatialIndex({proto_trans_catalogue.stop_index().begin(),
+                                                  proto_trans_catalogue.stop_index().end()});
+        } else {
+            transport_catalogue_.BuildSpatialIndex();
         }
+        // Расстояния загружаются до маршрутов: статистика маршрута считается при его добавлении
         for (const auto& dist_message : proto_trans_catalogue.distances()) {
-            transport_catalogue_.SetDistance(GetStopPtr(dist_message.from(), proto_trans_catalogue),
-                                             GetStopPtr(dist_message.to(), proto_trans_catalogue),
-                                             dist_message.distance());
+            transport_catalogue_.SetDistance(dist_message.from(), dist_message.to(), dist_message.distance());
+        }
+        for (const auto& bus : proto_trans_catalogue.buses()) {
+            transport_catalogue_.AddBus(GetDeserializeBus(bus));
         }
         map_renderer_.SetRenderSettings(GetDeserializeRenderSettings(proto_trans_catalogue.render_settings()));
-        router_.SetSettingsAndBuildGraph(GetDeserializeRouterSettings(proto_trans_catalogue.router_settings()));
+        DeserializeRouter(proto_trans_catalogue);
     }
 
 }
 
 proto_catalogue::Stop Serializer::GetSerializeStop(const Stop *stop_ptr) {
     proto_catalogue::Stop proto_stop;
-    proto_stop.set_name(stop_ptr->name);
-    proto_stop.mutable_coordinates()->set_latitude(stop_ptr->coordinates.lat);
-    proto_stop.mutable_coordinates()->set_longitude(stop_ptr->coordinates.lng);
+    proto_stop.set_name(stop_ptr->name.data(), stop_ptr->name.size());
+    if (transport_catalogue_.GetGeoSettings().compact_coordinates) {
+        const auto compact = geo::CompactCoordinates::FromCoordinates(stop_ptr->coordinates);
+        proto_stop.mutable_coordinates()->set_latitude_e6(compact.lat);
+        proto_stop.mutable_coordinates()->set_longitude_e6(compact.lng);
+    } else {
+        proto_stop.mutable_coordinates()->set_latitude(stop_ptr->coordinates.lat);
+        proto_stop.mutable_coordinates()->set_longitude(stop_ptr->coordinates.lng);
+    }
     return proto_stop;
 }
 
 Stop Serializer::GetDeserializeStop(const proto_catalogue::Stop &proto_stop) {
     Stop stop;
     stop.name = proto_stop.name();
-    stop.coordinates = {proto_stop.coordinates().latitude(), proto_stop.coordinates().longitude()};
+    if (transport_catalogue_.GetGeoSettings().compact_coordinates) {
+        stop.coordinates = geo::CompactCoordinates{proto_stop.coordinates().latitude_e6(),
+                                                   proto_stop.coordinates().longitude_e6()}.ToCoordinates();
+    } else {
+        stop.coordinates = {proto_stop.coordinates().latitude(), proto_stop.coordinates().longitude()};
+    }
     return stop;
 }
 
 proto_catalogue::Bus Serializer::GetSerializeBus(const Bus *bus_ptr) {
     proto_catalogue::Bus proto_bus;
-    proto_bus.set_name(bus_ptr->name);
+    proto_bus.set_name(bus_ptr->name.data(), bus_ptr->name.size());
     proto_bus.set_is_round_route(bus_ptr->is_round_route);
-    for (const auto& stop : bus_ptr->stops) {
-        proto_bus.add_stops_on_route(reinterpret_cast<uint64_t>(stop));
+    for (const StopId stop : bus_ptr->stops) {
+        proto_bus.add_stops_on_route(stop);
     }
     return proto_bus;
 }
 
-Bus Serializer::GetDeserializeBus(const proto_catalogue::Bus &proto_bus,
-                                  const ProtoCatalogue& proto_trans_catalogue) {
+Bus Serializer::GetDeserializeBus(const proto_catalogue::Bus &proto_bus) {
     Bus bus;
     bus.name = proto_bus.name();
     bus.is_round_route = proto_bus.is_round_route();
-    for (const auto& stop_id : proto_bus.stops_on_route()) {
-        const auto& stop_name = proto_trans_catalogue.stops().at(stop_id).name();
-        bus.stops.emplace_back(transport_catalogue_.FindStop(stop_name));
-    }
+    bus.stops.assign(proto_bus.stops_on_route().begin(), proto_bus.stops_on_route().end());
     return bus;
 }
 
-proto_catalogue::Distances Serializer::GetSerializeDistance(const Stop *from, const Stop *to, int distance) {
+proto_catalogue::Distances Serializer::GetSerializeDistance(StopId from, StopId to, int distance) {
     proto_catalogue::Distances proto_distance;
-    proto_distance.set_from(reinterpret_cast<uint64_t>(from));
-    proto_distance.set_to(reinterpret_cast<uint64_t>(to));
+    proto_distance.set_from(from);
+    proto_distance.set_to(to);
     proto_distance.set_distance(distance);
     return proto_distance;
 }
 
-const Stop* Serializer::GetStopPtr(uint64_t stop_id, const ProtoCatalogue &proto_trans_catalogue) {
-    return transport_catalogue_.FindStop(proto_trans_catalogue.stops().at(stop_id).name());
+proto_catalogue::NameIndex Serializer::GetSerializeNameIndex(
+        const transport_catalogue::NameArena::PerfectHash& perfect_hash) {
+    proto_catalogue::NameIndex proto_index;
+    *proto_index.mutable_seeds() = {perfect_hash.seeds.begin(), perfect_hash.seeds.end()};
+    *proto_index.mutable_slots() = {perfect_hash.slots.begin(), perfect_hash.slots.end()};
+    return proto_index;
+}
+
+transport_catalogue::NameArena::PerfectHash Serializer::GetDeserializeNameIndex(
+        const proto_catalogue::NameIndex& proto_index) {
+    return {{proto_index.seeds().begin(), proto_index.seeds().end()},
+            {proto_index.slots().begin(), proto_index.slots().end()}};
+}
+
+proto_catalogue::GeoSettings Serializer::GetSerializeGeoSettings(const GeoSettings& geo_settings) {
+    proto_catalogue::GeoSettings proto_settings;
+    proto_settings.set_equirectangular_distance(geo_settings.distance_mode == geo::DistanceMode::EQUIRECTANGULAR);
+    proto_settings.set_compact_coordinates(geo_settings.compact_coordinates);
+    return proto_settings;
+}
+
+Serializer::GeoSettings Serializer::GetDeserializeGeoSettings(const proto_catalogue::GeoSettings& proto_settings) {
+    GeoSettings geo_settings;
+    geo_settings.distance_mode = proto_settings.equirectangular_distance() ? geo::DistanceMode::EQUIRECTANGULAR
+                                                                           : geo::DistanceMode::SPHERICAL;
+    geo_settings.compact_coordinates = proto_settings.compact_coordinates();
+    return geo_settings;
 }
 
 proto_catalogue::Color Serializer::GetSerializeColor(const svg::Color& color) {
@@ -189,6 +237,8 @@ Serializer::ProtoRouterSettings Serializer::GetSerializeRouterSettings(const Rou
     proto_catalogue::RouterSettings proto_router_settings;
     proto_router_settings.set_time(router_settings.wait_time);
     proto_router_settings.set_velocity(router_settings.velocity);
+    proto_router_settings.set_router_type(static_cast<proto_catalogue::RouterType>(router_settings.router_type));
+    proto_router_settings.set_graph_model(static_cast<proto_catalogue::GraphModel>(router_settings.graph_model));
     return proto_router_settings;
 }
 
@@ -196,5 +246,180 @@ Serializer::RouterSettings Serializer::GetDeserializeRouterSettings(const ProtoR
     RouterSettings router_settings;
     router_settings.wait_time = proto_settings.time();
     router_settings.velocity = proto_settings.velocity();
+    router_settings.router_type = static_cast<transport_router::TransportRouter::RouterType>(proto_settings.router_type());
+    router_settings.graph_model = static_cast<transport_router::TransportRouter::GraphModel>(proto_settings.graph_model());
     return router_settings;
+}
+
+proto_catalogue::RouterData Serializer::GetSerializeRouterData() {
+    using transport_router::TransportRouter;
+    proto_catalogue::RouterData proto_router_data;
+    *proto_router_data.mutable_graph() = GetSerializeGraph(router_.GetGraph());
+    for (const auto& [edge_id, item] : router_.GetEdgeItems()) {
+        proto_catalogue::Item& proto_item = *proto_router_data.add_items();
+        // Значения перечислений ItemType совпадают
+        proto_item.set_type(static_cast<proto_catalogue::ItemType>(item.type));
+        if (item.type == TransportRouter::ItemType::WAIT) {
+            proto_item.set_name_id(transport_catalogue_.FindStop(item.route_name)->id);
+        } else {
+            proto_item.set_name_id(transport_catalogue_.FindBus(item.route_name)->id);
+        }
+        proto_item.set_time(item.time);
+        proto_item.set_span_count(item.span_count);
+        proto_item.set_length(item.length);
+    }
+    const auto& router = router_.GetRouter();
+    if (const auto* all_pairs = dynamic_cast<const graph::Router<double>*>(&router)) {
+        *proto_router_data.mutable_all_pairs() = GetSerializeAllPairsRoutes(*all_pairs);
+    } else if (const auto* compact = dynamic_cast<const CompactAllPairsRouter*>(&router)) {
+        *proto_router_data.mutable_compact_all_pairs() = GetSerializeCompactAllPairsRoutes(*compact);
+    } else if (const auto* hierarchy = dynamic_cast<const graph::ContractionHierarchyRouter<double>*>(&router)) {
+        *proto_router_data.mutable_hierarchy() = GetSerializeHierarchy(*hierarchy);
+    }
+    return proto_router_data;
+}
+
+void Serializer::DeserializeRouter(const ProtoCatalogue& proto_trans_catalogue) {
+    using transport_router::TransportRouter;
+    const RouterSettings router_settings = GetDeserializeRouterSettings(proto_trans_catalogue.router_settings());
+    if (!proto_trans_catalogue.has_router_data()) {
+        // База без предрасчитанных данных: строим граф заново
+        router_.SetSettingsAndBuildGraph(router_settings);
+        return;
+    }
+    const auto& proto_router_data = proto_trans_catalogue.router_data();
+    std::unique_ptr<Graph> graph = GetDeserializeGraph(proto_router_data.graph());
+
+    TransportRouter::EdgeItems items;
+    for (int edge_id = 0; edge_id < proto_router_data.items_size(); ++edge_id) {
+        const auto& proto_item = proto_router_data.items(edge_id);
+        TransportRouter::Item item{};
+        item.type = static_cast<TransportRouter::ItemType>(proto_item.type());
+        if (proto_item.type() == proto_catalogue::WAIT) {
+            item.route_name = transport_catalogue_.GetStop(proto_item.name_id())->name;
+        } else {
+            item.route_name = transport_catalogue_.GetBus(proto_item.name_id())->name;
+        }
+        item.time = proto_item.time();
+        item.span_count = proto_item.span_count();
+        item.length = proto_item.length();
+        items.emplace_hint(items.end(), edge_id, item);
+    }
+
+    std::unique_ptr<graph::BaseRouter<double>> router;
+    if (proto_router_data.has_all_pairs()) {
+        router = std::make_unique<graph::Router<double>>(
+                *graph, GetDeserializeAllPairsRoutes(proto_router_data.all_pairs(), graph->GetVertexCount()));
+    } else if (proto_router_data.has_compact_all_pairs()) {
+        router = std::make_unique<CompactAllPairsRouter>(
+                *graph, GetDeserializeCompactAllPairsRoutes(proto_router_data.compact_all_pairs(), graph->GetVertexCount()));
+    } else if (proto_router_data.has_hierarchy()) {
+        router = std::make_unique<graph::ContractionHierarchyRouter<double>>(
+                *graph, GetDeserializeHierarchy(proto_router_data.hierarchy()));
+    }
+    // Для движков без предрасчёта маршрутизатор создаётся по настройкам
+    router_.SetPrecomputedRouter(router_settings, std::move(graph), std::move(items),
+                                 std::move(router));
+}
+
+proto_catalogue::Graph Serializer::GetSerializeGraph(const Graph& graph) {
+    proto_catalogue::Graph proto_graph;
+    proto_graph.set_vertex_count(graph.GetVertexCount());
+    for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        proto_catalogue::Edge& proto_edge = *proto_graph.add_edges();
+        proto_edge.set_from(edge.from);
+        proto_edge.set_to(edge.to);
+        proto_edge.set_weight(edge.weight);
+    }
+    return proto_graph;
+}
+
+std::unique_ptr<Serializer::Graph> Serializer::GetDeserializeGraph(const proto_catalogue::Graph& proto_graph) {
+    auto graph = std::make_unique<Graph>(proto_graph.vertex_count());
+    for (const auto& proto_edge : proto_graph.edges()) {
+        graph->AddEdge({proto_edge.from(), proto_edge.to(), proto_edge.weight()});
+    }
+    return graph;
+}
+
+proto_catalogue::AllPairsRoutes Serializer::GetSerializeAllPairsRoutes(const graph::Router<double>& router) {
+    proto_catalogue::AllPairsRoutes proto_routes;
+    const auto& [weights, prev_edges] = router.GetRoutesInternalData();
+    proto_routes.mutable_weights()->Add(weights.begin(), weights.end());
+    proto_routes.mutable_prev_edges()->Reserve(static_cast<int>(prev_edges.size()));
+    for (const graph::EdgeId prev_edge : prev_edges) {
+        proto_routes.add_prev_edges(prev_edge == graph::Router<double>::NO_EDGE ? std::numeric_limits<uint64_t>::max()
+                                                                               : prev_edge);
+    }
+    return proto_routes;
+}
+
+graph::Router<double>::RoutesInternalData Serializer::GetDeserializeAllPairsRoutes(
+        const proto_catalogue::AllPairsRoutes& proto_routes, size_t vertex_count) {
+    if (static_cast<size_t>(proto_routes.weights_size()) != vertex_count * vertex_count
+        || proto_routes.prev_edges_size() != proto_routes.weights_size()) {
+        throw std::invalid_argument("Routes internal data doesn't match the graph");
+    }
+    graph::Router<double>::RoutesInternalData routes_internal_data;
+    routes_internal_data.weights.assign(proto_routes.weights().begin(), proto_routes.weights().end());
+    routes_internal_data.prev_edges.reserve(proto_routes.prev_edges_size());
+    for (const uint64_t prev_edge : proto_routes.prev_edges()) {
+        routes_internal_data.prev_edges.push_back(prev_edge == std::numeric_limits<uint64_t>::max()
+                                                  ? graph::Router<double>::NO_EDGE
+                                                  : static_cast<graph::EdgeId>(prev_edge));
+    }
+    return routes_internal_data;
+}
+
+proto_catalogue::CompactAllPairsRoutes Serializer::GetSerializeCompactAllPairsRoutes(
+        const CompactAllPairsRouter& router) {
+    // Метки отсутствия маршрута и ребра у компактных таблиц совпадают с форматом файла
+    proto_catalogue::CompactAllPairsRoutes proto_routes;
+    const auto& [weights, prev_edges] = router.GetRoutesInternalData();
+    proto_routes.mutable_weights()->Add(weights.begin(), weights.end());
+    proto_routes.mutable_prev_edges()->Add(prev_edges.begin(), prev_edges.end());
+    return proto_routes;
+}
+
+Serializer::CompactAllPairsRouter::RoutesInternalData Serializer::GetDeserializeCompactAllPairsRoutes(
+        const proto_catalogue::CompactAllPairsRoutes& proto_routes, size_t vertex_count) {
+    if (static_cast<size_t>(proto_routes.weights_size()) != vertex_count * vertex_count
+        || proto_routes.prev_edges_size() != proto_routes.weights_size()) {
+        throw std::invalid_argument("Routes internal data doesn't match the graph");
+    }
+    CompactAllPairsRouter::RoutesInternalData routes_internal_data;
+    routes_internal_data.weights.assign(proto_routes.weights().begin(), proto_routes.weights().end());
+    routes_internal_data.prev_edges.assign(proto_routes.prev_edges().begin(), proto_routes.prev_edges().end());
+    return routes_internal_data;
+}
+
+proto_catalogue::ContractionHierarchy Serializer::GetSerializeHierarchy(
+        const graph::ContractionHierarchyRouter<double>& router) {
+    proto_catalogue::ContractionHierarchy proto_hierarchy;
+    const auto hierarchy = router.GetHierarchy();
+    for (const size_t rank : hierarchy.ranks) {
+        proto_hierarchy.add_ranks(rank);
+    }
+    for (const auto& shortcut : hierarchy.shortcuts) {
+        proto_catalogue::Shortcut& proto_shortcut = *proto_hierarchy.add_shortcuts();
+        proto_shortcut.set_from(shortcut.from);
+        proto_shortcut.set_to(shortcut.to);
+        proto_shortcut.set_weight(shortcut.weight);
+        proto_shortcut.set_first(shortcut.first);
+        proto_shortcut.set_second(shortcut.second);
+    }
+    return proto_hierarchy;
+}
+
+graph::ContractionHierarchyRouter<double>::Hierarchy Serializer::GetDeserializeHierarchy(
+        const proto_catalogue::ContractionHierarchy& proto_hierarchy) {
+    graph::ContractionHierarchyRouter<double>::Hierarchy hierarchy;
+    hierarchy.ranks.assign(proto_hierarchy.ranks().begin(), proto_hierarchy.ranks().end());
+    hierarchy.shortcuts.reserve(proto_hierarchy.shortcuts_size());
+    for (const auto& proto_shortcut : proto_hierarchy.shortcuts()) {
+        hierarchy.shortcuts.push_back({proto_shortcut.from(), proto_shortcut.to(), proto_shortcut.weight(),
+                                       proto_shortcut.first(), proto_shortcut.second()});
+    }
+    return hierarchy;
 }
\ No newline at end of file
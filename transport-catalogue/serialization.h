@@ -1,5 +1,7 @@
 #pragma once
 #include <fstream>
+#include <memory>
+#include <unordered_map>
 
 #include "transport_catalogue.pb.h"
 #include "map_renderer.pb.h"
@@ -38,9 +40,13 @@ private:
     proto_catalogue::Stop GetSerializeStop(const Stop* stop_ptr);
     Stop GetDeserializeStop(const proto_catalogue::Stop& proto_stop);
     proto_catalogue::Bus GetSerializeBus(const Bus* bus_ptr);
-    Bus GetDeserializeBus(const proto_catalogue::Bus& proto_bus, const ProtoCatalogue& proto_trans_catalogue);
-    proto_catalogue::Distances GetSerializeDistance(const Stop* from, const Stop* to, int distance);
-    const Stop* GetStopPtr(uint64_t stop_id, const ProtoCatalogue& proto_trans_catalogue);
+    Bus GetDeserializeBus(const proto_catalogue::Bus& proto_bus);
+    proto_catalogue::Distances GetSerializeDistance(StopId from, StopId to, int distance);
+    proto_catalogue::NameIndex GetSerializeNameIndex(const transport_catalogue::NameArena::PerfectHash& perfect_hash);
+    transport_catalogue::NameArena::PerfectHash GetDeserializeNameIndex(const proto_catalogue::NameIndex& proto_index);
+    using GeoSettings = transport_catalogue::TransportCatalogue::GeoSettings;
+    proto_catalogue::GeoSettings GetSerializeGeoSettings(const GeoSettings& geo_settings);
+    GeoSettings GetDeserializeGeoSettings(const proto_catalogue::GeoSettings& proto_settings);
 
     // Сериализация/десериализация настроек построения карты маршрутов
     using MapSettings = renderer::MapRendererSettings;
@@ -57,5 +63,23 @@ private:
 
     ProtoRouterSettings GetSerializeRouterSettings(const RouterSettings& router_settings);
     RouterSettings GetDeserializeRouterSettings(const ProtoRouterSettings& proto_settings);
+
+    // Сериализация/десериализация построенного графа и таблиц маршрутизатора
+    using Graph = transport_router::TransportRouter::Graph;
+    using CompactAllPairsRouter = transport_router::TransportRouter::CompactAllPairsRouter;
+
+    proto_catalogue::RouterData GetSerializeRouterData();
+    void DeserializeRouter(const ProtoCatalogue& proto_trans_catalogue);
+    proto_catalogue::Graph GetSerializeGraph(const Graph& graph);
+    std::unique_ptr<Graph> GetDeserializeGraph(const proto_catalogue::Graph& proto_graph);
+    proto_catalogue::AllPairsRoutes GetSerializeAllPairsRoutes(const graph::Router<double>& router);
+    graph::Router<double>::RoutesInternalData GetDeserializeAllPairsRoutes(const proto_catalogue::AllPairsRoutes& proto_routes,
+                                                                          size_t vertex_count);
+    proto_catalogue::CompactAllPairsRoutes GetSerializeCompactAllPairsRoutes(const CompactAllPairsRouter& router);
+    CompactAllPairsRouter::RoutesInternalData GetDeserializeCompactAllPairsRoutes(
+            const proto_catalogue::CompactAllPairsRoutes& proto_routes, size_t vertex_count);
+    proto_catalogue::ContractionHierarchy GetSerializeHierarchy(const graph::ContractionHierarchyRouter<double>& router);
+    graph::ContractionHierarchyRouter<double>::Hierarchy GetDeserializeHierarchy(
+            const proto_catalogue::ContractionHierarchy& proto_hierarchy);
 };
 } //namespace serialize
\ No newline at end of file
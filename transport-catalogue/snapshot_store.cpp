@@ -0,0 +1,82 @@
+#include "snapshot_store.h"
+
+#include <atomic>
+#include <utility>
+
+namespace transport_catalogue {
+
+    using transport_router::TransportRouter;
+
+    SnapshotStore::SnapshotStore(TransportCatalogue catalogue, const TransportRouter::RouteSettings& route_settings) {
+        auto published = std::make_shared<const TransportCatalogue>(std::move(catalogue));
+        auto router = BuildRouter(published, route_settings);
+        current_ = std::make_shared<const Snapshot>(Snapshot{0, std::move(published), std::move(router)});
+    }
+
+    SnapshotStore::SnapshotStore(std::shared_ptr<const TransportCatalogue> catalogue,
+                                 std::shared_ptr<const TransportRouter> router) {
+        // Указатель на тот же маршрутизатор, который держит ещё и справочник
+        std::shared_ptr<const TransportRouter> holder(router.get(), [router, catalogue](const TransportRouter*) {
+        });
+        current_ = std::make_shared<const Snapshot>(Snapshot{0, std::move(catalogue), std::move(holder)});
+    }
+
+    std::shared_ptr<const Snapshot> SnapshotStore::GetSnapshot() const {
+        return std::atomic_load(&current_);
+    }
+
+    std::shared_ptr<const Snapshot> SnapshotStore::Update(const Edit& edit) {
+        std::lock_guard guard(update_mutex_);
+        // Писатель один, поэтому текущая версия не меняется до публикации
+        const std::shared_ptr<const Snapshot> previous = std::atomic_load(&current_);
+
+        auto catalogue = std::make_shared<TransportCatalogue>(*previous->catalogue);
+        edit(*catalogue);
+        const TransportCatalogue::Changes changes = catalogue->GetChanges(*previous->catalogue);
+        if (changes.coordinates) {
+            catalogue->BuildSpatialIndex();
+        }
+        if (changes.names) {
+            catalogue->BuildNameIndexes();
+        }
+
+        std::shared_ptr<const TransportCatalogue> published = std::move(catalogue);
+        // Граф зависит только от остановок, маршрутов и расстояний, поэтому при прочих изменениях
+        // прежний маршрутизатор отвечает так же (он держит свою версию справочника; оценка A*
+        // по прежним координатам согласована с тем же графом и остаётся допустимой)
+        auto router = changes.routes ? BuildRouter(published, previous->router->GetSettings()) : previous->router;
+        auto next = std::make_shared<const Snapshot>(Snapshot{previous->version + 1, std::move(published),
+                                                              std::move(router)});
+        std::atomic_store(&current_, next);
+        return next;
+    }
+
+    std::shared_ptr<const Snapshot> SnapshotStore::UpdateRouteSettings(
+            const TransportRouter::RouteSettings& route_settings) {
+        std::lock_guard guard(update_mutex_);
+        const std::shared_ptr<const Snapshot> previous = std::atomic_load(&current_);
+
+        auto router = std::make_unique<TransportRouter>(*previous->catalogue);
+        router->UpdateSettingsFrom(*previous->router, route_settings);
+        auto next = std::make_shared<const Snapshot>(Snapshot{previous->version + 1, previous->catalogue,
+                                                              HoldCatalogue(std::move(router), previous->catalogue)});
+        std::atomic_store(&current_, next);
+        return next;
+    }
+
+    std::shared_ptr<const TransportRouter> SnapshotStore::BuildRouter(
+            std::shared_ptr<const TransportCatalogue> catalogue, const TransportRouter::RouteSettings& route_settings) {
+        auto router = std::make_unique<TransportRouter>(*catalogue);
+        router->SetSettingsAndBuildGraph(route_settings);
+        return HoldCatalogue(std::move(router), std::move(catalogue));
+    }
+
+    std::shared_ptr<const TransportRouter> SnapshotStore::HoldCatalogue(std::unique_ptr<TransportRouter> router,
+                                                                        std::shared_ptr<const TransportCatalogue> catalogue) {
+        return std::shared_ptr<const TransportRouter>(router.release(),
+                                                      [catalogue](const TransportRouter* router) {
+                                                          delete router;
+                                                      });
+    }
+
+}  // namespace transport_catalogue
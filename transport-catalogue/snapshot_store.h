@@ -0,0 +1,69 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace transport_catalogue {
+
+    // Неизменяемая версия справочника и маршрутизатор, построенный по ней.
+    // Маршрутизатор держит справочник, поэтому его можно использовать и без снимка
+    struct Snapshot {
+        uint64_t version = 0;
+        std::shared_ptr<const TransportCatalogue> catalogue;
+        std::shared_ptr<const transport_router::TransportRouter> router;
+    };
+
+    // Версии справочника для одновременных запросов и обновлений.
+    // Читатель берёт текущий снимок и работает с ним сколько угодно долго; снимок не меняется,
+    // а память версии освобождается, когда отпущен последний её снимок.
+    // Писатель копирует текущий справочник (копия разделяет с ним все неизменённые части), меняет копию,
+    // перестраивает по ней затронутые изменением индексы и маршрутизатор и атомарно публикует новую версию.
+    // Маршрутизатор строится заново, только если изменились остановки, маршруты или расстояния:
+    // тогда обновление стоит столько же, сколько его построение (для all_pairs - O(V^3)).
+    // Чтение не ждёт обновлений; обновления выполняются по одному
+    class SnapshotStore {
+    public:
+        using Edit = std::function<void(TransportCatalogue&)>;
+
+        // Первая версия: справочник с построенными индексами и настройки маршрутизатора
+        SnapshotStore(TransportCatalogue catalogue,
+                      const transport_router::TransportRouter::RouteSettings& route_settings);
+
+        // Первая версия из готовых справочника и маршрутизатора (например, загруженных из базы).
+        // Маршрутизатор должен быть построен по этому справочнику
+        SnapshotStore(std::shared_ptr<const TransportCatalogue> catalogue,
+                      std::shared_ptr<const transport_router::TransportRouter> router);
+
+        // Текущая версия
+        std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+        // Новая версия: edit меняет копию текущего справочника. Если edit бросает исключение,
+        // текущая версия остаётся прежней. Возвращает опубликованный снимок
+        std::shared_ptr<const Snapshot> Update(const Edit& edit);
+
+        // Новая версия с тем же справочником и новыми скоростью и временем ожидания: граф маршрутизатора
+        // копируется и перевзвешивается (TransportRouter::UpdateSettingsFrom), а не строится заново
+        std::shared_ptr<const Snapshot> UpdateRouteSettings(
+                const transport_router::TransportRouter::RouteSettings& route_settings);
+
+    private:
+        // Маршрутизатор с настройками, который держит свой справочник
+        static std::shared_ptr<const transport_router::TransportRouter> BuildRouter(
+                std::shared_ptr<const TransportCatalogue> catalogue,
+                const transport_router::TransportRouter::RouteSettings& route_settings);
+
+        // Справочник освобождается не раньше маршрутизатора, который на него ссылается
+        static std::shared_ptr<const transport_router::TransportRouter> HoldCatalogue(
+                std::unique_ptr<transport_router::TransportRouter> router,
+                std::shared_ptr<const TransportCatalogue> catalogue);
+
+        std::shared_ptr<const Snapshot> current_; // Читается и заменяется через std::atomic_load / std::atomic_store
+        std::mutex update_mutex_; // Очередь писателей
+    };
+
+}  // namespace transport_catalogue
@@ -0,0 +1,136 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace transport_catalogue {
+    namespace {
+        const double EARTH_RADIUS = 6371000.;
+    }
+
+    SpatialIndex::SpatialIndex(const std::vector<geo::Coordinates>& coordinates)
+            : order_(coordinates.size()) {
+        std::vector<Point> stop_points;
+        stop_points.reserve(coordinates.size());
+        for (const auto& stop_coordinates : coordinates) {
+            stop_points.push_back(ToPoint(stop_coordinates));
+        }
+        std::iota(order_.begin(), order_.end(), StopId{0});
+        Build(stop_points, 0, order_.size(), 0);
+        points_.reserve(order_.size());
+        for (const StopId stop : order_) {
+            points_.push_back(stop_points[stop]);
+        }
+    }
+
+    SpatialIndex::SpatialIndex(const std::vector<geo::Coordinates>& coordinates, std::vector<StopId> order)
+            : order_(std::move(order)) {
+        if (order_.size() != coordinates.size()) {
+            throw std::invalid_argument("Spatial index doesn't match stops");
+        }
+        points_.reserve(order_.size());
+        for (const StopId stop : order_) {
+            points_.push_back(ToPoint(coordinates.at(stop)));
+        }
+    }
+
+    std::vector<SpatialIndex::Neighbour> SpatialIndex::FindNearest(const std::vector<geo::Coordinates>& coordinates,
+                                                                   const geo::Coordinates& point, size_t count,
+                                                                   double max_distance) const {
+        std::vector<Neighbour> result;
+        if (count == 0 || max_distance < 0) {
+            return result;
+        }
+        // Радиус по поверхности переводится в длину хорды, небольшой запас на погрешность
+        // убирается проверкой точного расстояния ниже
+        double bound = std::numeric_limits<double>::infinity();
+        if (max_distance < M_PI * EARTH_RADIUS) {
+            const double chord = 2 * EARTH_RADIUS * std::sin(max_distance / (2 * EARTH_RADIUS)) * (1 + 1e-9) + 1e-6;
+            bound = chord * chord;
+        }
+        std::vector<Candidate> heap;
+        Search(0, order_.size(), 0, ToPoint(point), count, heap, bound);
+        std::sort_heap(heap.begin(), heap.end());
+        result.reserve(heap.size());
+        for (const auto& [squared_chord, stop] : heap) {
+            const double distance = geo::ComputeDistance(point, coordinates[stop]);
+            if (distance <= max_distance) {
+                result.push_back({stop, distance});
+            }
+        }
+        return result;
+    }
+
+    const std::vector<StopId>& SpatialIndex::GetOrder() const {
+        return order_;
+    }
+
+    SpatialIndex::Point SpatialIndex::ToPoint(const geo::Coordinates& coordinates) {
+        static const double dr = M_PI / 180.;
+        const double lat = coordinates.lat * dr;
+        const double lng = coordinates.lng * dr;
+        return {{EARTH_RADIUS * std::cos(lat) * std::cos(lng),
+                 EARTH_RADIUS * std::cos(lat) * std::sin(lng),
+                 EARTH_RADIUS * std::sin(lat)}};
+    }
+
+    double SpatialIndex::SquaredChord(const Point& from, const Point& to) {
+        double result = 0.;
+        for (int axis = 0; axis < 3; ++axis) {
+            const double diff = from.coordinates[axis] - to.coordinates[axis];
+            result += diff * diff;
+        }
+        return result;
+    }
+
+    void SpatialIndex::Build(const std::vector<Point>& stop_points, size_t begin, size_t end, int axis) {
+        if (end - begin <= 1) {
+            return;
+        }
+        const size_t middle = begin + (end - begin) / 2;
+        std::nth_element(order_.begin() + begin, order_.begin() + middle, order_.begin() + end,
+                         [&stop_points, axis](StopId lhs, StopId rhs) {
+                             return stop_points[lhs].coordinates[axis] < stop_points[rhs].coordinates[axis];
+                         });
+        Build(stop_points, begin, middle, (axis + 1) % 3);
+        Build(stop_points, middle + 1, end, (axis + 1) % 3);
+    }
+
+    void SpatialIndex::Search(size_t begin, size_t end, int axis, const Point& target, size_t count,
+                              std::vector<Candidate>& heap, double& bound) const {
+        if (begin >= end) {
+            return;
+        }
+        const size_t middle = begin + (end - begin) / 2;
+        const Candidate candidate = {SquaredChord(points_[middle], target), order_[middle]};
+        if (candidate.first <= bound && (heap.size() < count || candidate < heap.front())) {
+            // Куча с максимумом в вершине: худший из найденных кандидатов вытесняется первым
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end());
+            if (heap.size() > count) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.pop_back();
+            }
+            if (heap.size() == count) {
+                bound = std::min(bound, heap.front().first);
+            }
+        }
+        const double diff = target.coordinates[axis] - points_[middle].coordinates[axis];
+        const int next_axis = (axis + 1) % 3;
+        // Сначала поддерево со стороны цели, затем другое, если плоскость разбиения ближе найденных кандидатов
+        if (diff < 0) {
+            Search(begin, middle, next_axis, target, count, heap, bound);
+            if (diff * diff <= bound) {
+                Search(middle + 1, end, next_axis, target, count, heap, bound);
+            }
+        } else {
+            Search(middle + 1, end, next_axis, target, count, heap, bound);
+            if (diff * diff <= bound) {
+                Search(begin, middle, next_axis, target, count, heap, bound);
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "geo.h"
+#include "domain.h"
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+
+    // Статическое k-d дерево по координатам остановок. Остановки переводятся в точки пространства (в метрах):
+    // длина хорды монотонна по расстоянию по поверхности, поэтому ближайшие по хорде остановки
+    // ближайшие и по geo::ComputeDistance. Дерево неявное: медиана отрезка [begin, end) массива
+    // порядка - корень поддерева, ось разбиения чередуется по глубине. Поэтому для восстановления
+    // индекса достаточно сохранить порядок остановок. Координаты остановок индекс не хранит:
+    // их массив из справочника передаётся в запрос
+    class SpatialIndex {
+    public:
+        struct Neighbour {
+            StopId stop;
+            double distance; // расстояние по поверхности в метрах
+        };
+
+        SpatialIndex() = default;
+
+        // Строим индекс по координатам остановок (индекс массива - номер остановки)
+        explicit SpatialIndex(const std::vector<geo::Coordinates>& coordinates);
+
+        // Восстанавливаем ранее построенный индекс по сохранённому порядку остановок
+        SpatialIndex(const std::vector<geo::Coordinates>& coordinates, std::vector<StopId> order);
+
+        // Не более count ближайших к точке остановок на расстоянии не больше max_distance,
+        // по возрастанию расстояния (при равенстве - по номеру остановки). coordinates - те же координаты
+        // остановок, по которым построен индекс
+        std::vector<Neighbour> FindNearest(const std::vector<geo::Coordinates>& coordinates,
+                                           const geo::Coordinates& point, size_t count,
+                                           double max_distance = std::numeric_limits<double>::infinity()) const;
+
+        const std::vector<StopId>& GetOrder() const;
+
+    private:
+        struct Point {
+            double coordinates[3] = {0., 0., 0.};
+        };
+
+        // Кандидат в ответ: квадрат длины хорды и номер остановки
+        using Candidate = std::pair<double, StopId>;
+
+        static Point ToPoint(const geo::Coordinates& coordinates);
+        static double SquaredChord(const Point& from, const Point& to);
+
+        void Build(const std::vector<Point>& stop_points, size_t begin, size_t end, int axis);
+        void Search(size_t begin, size_t end, int axis, const Point& target, size_t count,
+                    std::vector<Candidate>& heap, double& bound) const;
+
+        std::vector<StopId> order_; // Номера остановок в порядке дерева
+        std::vector<Point> points_; // Точки остановок в порядке дерева
+    };
+
+}  // namespace transport_catalogue
@@ -23,7 +23,7 @@ namespace output {
     }
 
     void GetBusInfoForOutput(TransportCatalogue& catalogue, const string_view& request, ostream& output) {
-        string bus_name = GetNameFromRequest(std::move(request));
+        string bus_name{GetNameFromRequest(request)};
         output << "Bus "s << bus_name << ": "s;
         const Bus* bus = catalogue.FindBus(std::move(bus_name));
         if (const auto bus_info = catalogue.GetBusInfo(bus); !bus_info.has_value()) {
@@ -38,7 +38,7 @@ namespace output {
     }
 
     void GetStopInfoForOutput(TransportCatalogue& catalogue, const string_view& request, ostream& output) {
-        string stop_name = GetNameFromRequest(std::move(request));
+        string stop_name{GetNameFromRequest(request)};
         output << "Stop "s << stop_name << ": "s;
         if (const auto stop_info = catalogue.GetStopInfo(stop_name); !stop_info.has_value()) {
             output << "not found"s;
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 #include "transport_catalogue.h"
@@ -9,111 +10,297 @@
 using namespace std::literals;
 
 namespace transport_catalogue {
+    void RealDistanceTable::Set(StopId from, StopId to, int distance) {
+        const StopId lower = std::min(from, to);
+        const StopId upper = std::max(from, to);
+        if (lower >= neighbours_.size()) {
+            neighbours_.resize(lower + 1);
+        }
+        auto& entries = neighbours_[lower];
+        auto it = std::lower_bound(entries.begin(), entries.end(), upper, [](const Entry& entry, StopId other) {
+            return entry.other < other;
+        });
+        if (it == entries.end() || it->other != upper) {
+            it = entries.insert(it, Entry{upper});
+        }
+        (from == lower ? it->forward : it->backward) = distance;
+    }
+
+    int RealDistanceTable::Get(StopId from, StopId to) const {
+        const StopId lower = std::min(from, to);
+        const StopId upper = std::max(from, to);
+        if (lower < neighbours_.size()) {
+            const auto& entries = neighbours_[lower];
+            const auto it = std::lower_bound(entries.begin(), entries.end(), upper, [](const Entry& entry, StopId other) {
+                return entry.other < other;
+            });
+            if (it != entries.end() && it->other == upper) {
+                const int direct = from == lower ? it->forward : it->backward;
+                return direct != NO_DISTANCE ? direct : (from == lower ? it->backward : it->forward);
+            }
+        }
+        throw std::out_of_range("Distance between stops is not set");
+    }
+
+    void TransportCatalogue::SetGeoSettings(const GeoSettings& settings) {
+        geo_settings_ = settings;
+        if (stops_->empty()) {
+            return;
+        }
+        auto& stops = stops_.Write();
+        auto& stop_coordinates = stop_coordinates_.Write();
+        auto& stop_points = stop_points_.Write();
+        for (Stop& stop : stops) {
+            stop.coordinates = PrepareCoordinates(stop.coordinates);
+            stop_coordinates[stop.id] = stop.coordinates;
+            stop_points.Set(stop.id, stop.coordinates);
+        }
+        auto& bus_infos = bus_infos_.Write();
+        for (const Bus& bus : *buses_) {
+            bus_infos[bus.id] = ComputeBusInfo(&bus);
+        }
+    }
+
+    const TransportCatalogue::GeoSettings& TransportCatalogue::GetGeoSettings() const {
+        return geo_settings_;
+    }
+
+    geo::Coordinates TransportCatalogue::PrepareCoordinates(const geo::Coordinates& coordinates) const {
+        if (geo_settings_.compact_coordinates) {
+            return geo::CompactCoordinates::FromCoordinates(coordinates).ToCoordinates();
+        }
+        return coordinates;
+    }
+
     void TransportCatalogue::AddStop(const Stop& stop) {
-        stops_.push_back(stop);
-        stop_names_[stops_.back().name] = &stops_.back();
+        auto& stops = stops_.Write();
+        stops.push_back(stop);
+        stops.back().id = static_cast<StopId>(stops.size() - 1);
+        stops.back().name = stop_names_.Write().Add(stop.name, stops.back().id);
+        stops.back().coordinates = PrepareCoordinates(stop.coordinates);
+        stop_coordinates_.Write().push_back(stops.back().coordinates);
+        stop_points_.Write().Add(stops.back().coordinates);
+        stop_buses_.Write().emplace_back();
     }
     void TransportCatalogue::AddBus(const Bus& bus) {
-        buses_.push_back(bus);
-        route_names_[buses_.back().name] = &buses_.back();
+        auto& buses = buses_.Write();
+        buses.push_back(bus);
+        buses.back().id = static_cast<BusId>(buses.size() - 1);
+        buses.back().name = bus_names_.Write().Add(bus.name, buses.back().id);
+        const std::string_view bus_name = buses.back().name;
+        route_names_.Write()[bus_name] = buses.back().id;
+        bus_infos_.Write().push_back(ComputeBusInfo(&buses.back()));
+        for (const StopId stop : buses.back().stops) {
+            AddStopBus(stop, bus_name);
+        }
     }
 
-    const Stop* TransportCatalogue::FindStop(const std::string_view& stop_name) const {
-        if (stop_names_.count(stop_name) != 0) {
-            return stop_names_.at(stop_name);
-        } else {
-            return nullptr;
+    void TransportCatalogue::AddStopBus(StopId stop, std::string_view bus_name) {
+        auto& stop_buses = stop_buses_.Write()[stop];
+        const auto it = std::lower_bound(stop_buses.begin(), stop_buses.end(), bus_name);
+        if (it == stop_buses.end() || *it != bus_name) {
+            stop_buses.insert(it, bus_name);
         }
     }
 
-    const Bus* TransportCatalogue::FindBus(std::string_view bus_name) const {
-        if (route_names_.count(bus_name) != 0) {
-            return route_names_.at(bus_name);
-        } else {
-            return nullptr;
-        }
+    void TransportCatalogue::UpdateStop(StopId id, const geo::Coordinates& new_coordinates) {
+        const geo::Coordinates coordinates = PrepareCoordinates(new_coordinates);
+        stops_.Write().at(id).coordinates = coordinates;
+        stop_coordinates_.Write()[id] = coordinates;
+        stop_points_.Write().Set(id, coordinates);
+        UpdateBusInfos(id);
     }
 
-    void TransportCatalogue::SetDistance(const Stop* from, const Stop* to, int distance) {
-        real_distances_[{from, to}] = distance;
+    void TransportCatalogue::UpdateBus(BusId id, std::vector<StopId> stops, bool is_round_route) {
+        Bus& bus = buses_.Write().at(id);
+        for (const StopId stop : bus.stops) {
+            auto& stop_buses = stop_buses_.Write()[stop];
+            const auto it = std::lower_bound(stop_buses.begin(), stop_buses.end(), bus.name);
+            if (it != stop_buses.end() && *it == bus.name) {
+                stop_buses.erase(it);
+            }
+        }
+        bus.stops = std::move(stops);
+        bus.is_round_route = is_round_route;
+        for (const StopId stop : bus.stops) {
+            AddStopBus(stop, bus.name);
+        }
+        bus_infos_.Write()[id] = ComputeBusInfo(&bus);
     }
 
-    int TransportCatalogue::GetRealDistance(const Stop* from, const Stop* to) const {
-        if (real_distances_.count({from, to})) {
-            return real_distances_.at({from, to});
-        } else {
-            return real_distances_.at({to, from});
+    void TransportCatalogue::UpdateBusInfos(StopId stop) {
+        if (stop >= stop_buses_->size() || (*stop_buses_)[stop].empty()) {
+            return;
+        }
+        auto& bus_infos = bus_infos_.Write();
+        for (const std::string_view bus_name : (*stop_buses_)[stop]) {
+            const BusId bus = bus_names_->Find(bus_name);
+            bus_infos[bus] = ComputeBusInfo(&(*buses_)[bus]);
         }
     }
 
+    const Stop* TransportCatalogue::FindStop(const std::string_view& stop_name) const {
+        const uint32_t id = stop_names_->Find(stop_name);
+        return id != NameArena::NO_ID ? &(*stops_)[id] : nullptr;
+    }
+
+    const Bus* TransportCatalogue::FindBus(std::string_view bus_name) const {
+        const uint32_t id = bus_names_->Find(bus_name);
+        return id != NameArena::NO_ID ? &(*buses_)[id] : nullptr;
+    }
+
+    const Stop* TransportCatalogue::GetStop(StopId id) const {
+        return &stops_->at(id);
+    }
+
+    const Bus* TransportCatalogue::GetBus(BusId id) const {
+        return &buses_->at(id);
+    }
+
+    const std::vector<geo::Coordinates>& TransportCatalogue::GetStopCoordinates() const {
+        return *stop_coordinates_;
+    }
+
+    void TransportCatalogue::SetDistance(StopId from, StopId to, int distance) {
+        real_distances_.Write().Set(from, to, distance);
+        // Маршруты с перегоном между from и to проходят через from
+        UpdateBusInfos(from);
+    }
+
+    int TransportCatalogue::GetRealDistance(StopId from, StopId to) const {
+        return real_distances_->Get(from, to);
+    }
+
     std::optional<BusInfo> TransportCatalogue::GetBusInfo(const Bus* bus) const {
         if (bus != nullptr) {
-            BusInfo bus_info;
-            bus_info.route_length = 0;
-            bus_info.curvature = 0.0;
-            double common_direct_distance = 0.0;
-            bus_info.stops_count = static_cast<int>(bus->stops.size());
-            std::unordered_set unique_stops(bus->stops.begin(), bus->stops.end());
-            bus_info.unique_stops_count = static_cast<int>(unique_stops.size());
-            for (size_t i = 1; i < bus->stops.size(); ++i) {
-                bus_info.route_length += GetRealDistance(bus->stops[i-1], bus->stops[i]);
-                common_direct_distance += geo::ComputeDistance(bus->stops[i-1]->coordinates, bus->stops[i]->coordinates);
-            }
-            bus_info.curvature = 1.0 * bus_info.route_length / common_direct_distance;
-            return bus_info;
+            return bus_infos_->at(bus->id);
         } else {
             return std::nullopt;
         }
     }
 
+    BusInfo TransportCatalogue::ComputeBusInfo(const Bus* bus) const {
+        BusInfo bus_info;
+        bus_info.route_length = 0;
+        bus_info.curvature = 0.0;
+        double common_direct_distance = 0.0;
+        bus_info.stops_count = static_cast<int>(bus->stops.size());
+        std::unordered_set unique_stops(bus->stops.begin(), bus->stops.end());
+        bus_info.unique_stops_count = static_cast<int>(unique_stops.size());
+        // Расстояния по прямой между соседними остановками считаются одним пакетом
+        std::vector<double> direct_distances(bus->stops.empty() ? 0 : bus->stops.size() - 1);
+        geo::ComputeDistances(*stop_points_, bus->stops.data(), bus->stops.data() + 1, direct_distances.size(),
+                              direct_distances.data(), geo_settings_.distance_mode);
+        for (size_t i = 1; i < bus->stops.size(); ++i) {
+            bus_info.route_length += GetRealDistance(bus->stops[i-1], bus->stops[i]);
+            common_direct_distance += direct_distances[i-1];
+        }
+        bus_info.curvature = 1.0 * bus_info.route_length / common_direct_distance;
+        return bus_info;
+    }
+
     std::optional<StopInfo> TransportCatalogue::GetStopInfo(const std::string_view& stop_name) const {
-        if (FindStop(stop_name) == nullptr) {
+        const Stop* stop = FindStop(stop_name);
+        if (stop == nullptr) {
             return std::nullopt;
-        } else {
-            StopInfo stop_info{};
-            std::for_each(route_names_.begin(), route_names_.end(),
-                          [stop_name, &stop_info] (const auto bus_info) {
-                              for (auto stop_on_route : bus_info.second->stops) {
-                                  if (stop_on_route->name == stop_name) {
-                                      stop_info.buses.insert(bus_info.second->name);
-                                      break;
-                                  }
-                              }
-                          });
-            return stop_info;
         }
+        return StopInfo{ranges::AsRange((*stop_buses_)[stop->id])};
     }
 
     const RealDistanceTable& TransportCatalogue::GetAllDistances() const {
-        return real_distances_;
+        return *real_distances_;
+    }
+
+    TransportCatalogue::Changes TransportCatalogue::GetChanges(const TransportCatalogue& original) const {
+        Changes changes;
+        changes.coordinates = !stop_coordinates_.IsSharedWith(original.stop_coordinates_);
+        changes.names = !stop_names_.IsSharedWith(original.stop_names_) || !bus_names_.IsSharedWith(original.bus_names_);
+        changes.routes = stops_->size() != original.stops_->size() || !buses_.IsSharedWith(original.buses_)
+                || !real_distances_.IsSharedWith(original.real_distances_);
+        return changes;
+    }
+
+    void TransportCatalogue::BuildSpatialIndex() {
+        spatial_index_.Write() = SpatialIndex(*stop_coordinates_);
+    }
+
+    void TransportCatalogue::SetSpatialIndex(std::vector<StopId> order) {
+        spatial_index_.Write() = SpatialIndex(*stop_coordinates_, std::move(order));
+    }
+
+    const SpatialIndex& TransportCatalogue::GetSpatialIndex() const {
+        return *spatial_index_;
+    }
+
+    void TransportCatalogue::BuildNameIndexes() {
+        stop_names_.Write().BuildPerfectHash();
+        bus_names_.Write().BuildPerfectHash();
+    }
+
+    void TransportCatalogue::SetNameIndexes(NameArena::PerfectHash stop_names, NameArena::PerfectHash bus_names) {
+        stop_names_.Write().SetPerfectHash(std::move(stop_names));
+        bus_names_.Write().SetPerfectHash(std::move(bus_names));
+    }
+
+    const NameArena::PerfectHash& TransportCatalogue::GetStopNameIndex() const {
+        return stop_names_->GetPerfectHash();
+    }
+
+    const NameArena::PerfectHash& TransportCatalogue::GetBusNameIndex() const {
+        return bus_names_->GetPerfectHash();
+    }
+
+    std::vector<NearbyStop> TransportCatalogue::FindNearestStops(const geo::Coordinates& point, size_t count,
+                                                                 double max_distance) const {
+        std::vector<NearbyStop> result;
+        for (const auto& [stop, distance] : spatial_index_->FindNearest(*stop_coordinates_, point, count, max_distance)) {
+            result.push_back({(*stops_)[stop].name, distance});
+        }
+        return result;
     }
 
     std::unordered_map<std::string_view, const Stop*> TransportCatalogue::GetStopNames() const {
-        return stop_names_;
+        std::unordered_map<std::string_view, const Stop*> stop_names;
+        for (const Stop& stop : *stops_) {
+            stop_names[stop.name] = &stop;
+        }
+        return stop_names;
     }
     std::map<std::string_view, const Bus*> TransportCatalogue::GetRouteNames() const {
-        return route_names_;
+        std::map<std::string_view, const Bus*> route_names;
+        for (const auto& [name, bus] : *route_names_) {
+            route_names.emplace_hint(route_names.end(), name, &(*buses_)[bus]);
+        }
+        return route_names;
+    }
+
+    size_t TransportCatalogue::GetStopsCount() const {
+        return stops_->size();
+    }
+
+    size_t TransportCatalogue::GetBusesCount() const {
+        return buses_->size();
     }
 
     void TransportCatalogue::TestGetStopNames() {
-        for (const auto& [name, name_link] : stop_names_) {
+        for (const auto& [name, name_link] : GetStopNames()) {
             std::cout << "Name: " << name << " <> " << " Link name: " << name_link->name << std::endl;
             std::cout << std::setprecision(8) << name_link->coordinates.lat << "___" << name_link->coordinates.lng << std::endl;
         }
     }
 
     void TransportCatalogue::TestGetBusNames() {
-        for (const auto& [bus, bus_link] : route_names_) {
+        for (const auto& [bus, bus_link] : GetRouteNames()) {
             std::cout << "Name: " << bus << " <> " << " Link name: " << bus_link->name << std::endl;
-            for (const auto& stop : bus_link->stops) {
-                std::cout << stop->name << std::endl;
+            for (const StopId stop : bus_link->stops) {
+                std::cout << (*stops_)[stop].name << std::endl;
             }
         }
     }
 
     void TransportCatalogue::TestGetDistancesBetweenStops() {
-        for (const auto& [pair_stops, dist] : real_distances_) {
-            std::cout << "1: " << pair_stops.first->name << " | 2: " << pair_stops.second->name << " ----- " << dist << std::endl;
-        }
+        real_distances_->ForEach([this](StopId from, StopId to, int dist) {
+            std::cout << "1: " << (*stops_)[from].name << " | 2: " << (*stops_)[to].name << " ----- " << dist << std::endl;
+        });
     }
 }
\ No newline at end of file
@@ -2,30 +2,125 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "spatial_index.h"
+#include "name_arena.h"
 
 #include <deque>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <optional>
+#include <vector>
 
 namespace transport_catalogue {
+    // Фактические расстояния между остановками. Для каждой пары остановок хранится одна запись
+    // в отсортированном списке соседей остановки с меньшим номером, с расстояниями в обе стороны,
+    // поэтому поиск с подстановкой обратного расстояния - один двоичный поиск по короткому массиву
+    class RealDistanceTable {
+    public:
+        void Set(StopId from, StopId to, int distance);
+
+        // Расстояние from -> to, а если оно не задано - to -> from.
+        // Бросает std::out_of_range, если не задано ни одно из них
+        int Get(StopId from, StopId to) const;
+
+        // Обход заданных расстояний: callback(from, to, distance)
+        template <typename Callback>
+        void ForEach(Callback callback) const;
+
+    private:
+        static constexpr int NO_DISTANCE = -1;
+
+        struct Entry {
+            StopId other; // остановка с большим номером
+            int forward = NO_DISTANCE; // расстояние от остановки с меньшим номером
+            int backward = NO_DISTANCE; // расстояние до остановки с меньшим номером
+        };
+
+        std::vector<std::vector<Entry>> neighbours_; // Соседи по номеру остановки, упорядоченные по other
+    };
+
+    template <typename Callback>
+    void RealDistanceTable::ForEach(Callback callback) const {
+        for (StopId stop = 0; stop < neighbours_.size(); ++stop) {
+            for (const Entry& entry : neighbours_[stop]) {
+                if (entry.forward != NO_DISTANCE) {
+                    callback(stop, entry.other, entry.forward);
+                }
+                if (entry.backward != NO_DISTANCE) {
+                    callback(entry.other, stop, entry.backward);
+                }
+            }
+        }
+    }
+
     namespace detail {
+        // Часть справочника, общая для его копий: копирование справочника копирует только указатели,
+        // а часть клонируется целиком при первом изменении, если её ещё разделяет другая копия
         template <typename T>
-        class Hasher{
+        class CopyOnWrite {
         public:
-            size_t operator() (const std::pair<T, T> pair_for_hash) const {
-                return hasher_(pair_for_hash.first) ^ hasher_(pair_for_hash.second);
+            CopyOnWrite() : value_(std::make_shared<T>()) {}
+            CopyOnWrite(const CopyOnWrite&) = default;
+            CopyOnWrite& operator=(const CopyOnWrite&) = default;
+
+            const T& operator*() const {
+                return *value_;
+            }
+            const T* operator->() const {
+                return value_.get();
+            }
+
+            // Доступ на изменение: после него часть принадлежит только этой копии
+            T& Write() {
+                if (value_.use_count() > 1) {
+                    value_ = std::make_shared<T>(*value_);
+                }
+                return *value_;
             }
+
+            // Часть не менялась ни в этой копии, ни в other с момента копирования
+            bool IsSharedWith(const CopyOnWrite& other) const {
+                return value_ == other.value_;
+            }
+
         private:
-            std::hash<T> hasher_;
+            std::shared_ptr<T> value_;
         };
     }
 
-    using RealDistanceTable = std::unordered_map<std::pair<const Stop*, const Stop*>, int, detail::Hasher<const Stop*>>;
-
+    // Справочник остановок и маршрутов. Копия справочника разделяет с оригиналом все данные и дублирует
+    // только те части, которые потом изменяет, поэтому следующую версию можно строить копированием
+    // текущей, пока её читают другие потоки (см. SnapshotStore). Часть дублируется целиком: изменение
+    // одной остановки копирует массивы всех остановок (O(число остановок)), но не маршруты, расстояния и названия
     class TransportCatalogue {
     public:
-        // Добавление данных об остановках / маршрутах в каталог
+        // Что изменилось в копии справочника по сравнению с оригиналом (GetChanges)
+        struct Changes {
+            bool coordinates = false; // координаты или число остановок: пространственный индекс
+            bool names = false; // добавлены остановки или маршруты: хэш-функции названий
+            bool routes = false; // остановки, маршруты или расстояния между остановками: граф маршрутов
+        };
+
+        // Геометрия справочника
+        struct GeoSettings {
+            // Расчёт расстояния по прямой между остановками для извилистости маршрутов
+            geo::DistanceMode distance_mode = geo::DistanceMode::SPHERICAL;
+            // Координаты остановок округляются до миллионных долей градуса (geo::CompactCoordinates)
+            // и в таком виде сохраняются в базе
+            bool compact_coordinates = false;
+        };
+
+        // Если остановки уже добавлены, их координаты округляются по новым настройкам (снятое округление
+        // прежней точности не возвращает), статистика маршрутов пересчитывается, а пространственный индекс
+        // нужно построить заново (BuildSpatialIndex)
+        void SetGeoSettings(const GeoSettings& settings);
+        const GeoSettings& GetGeoSettings() const;
+
+        // Добавление данных об остановках / маршрутах в каталог. Номер (id) назначается каталогом.
+        // Статистика маршрута считается при добавлении, поэтому расстояния между его остановками
+        // должны быть заданы заранее. Остановки маршрута перечисляются полностью: у некольцевого
+        // маршрута - туда и обратно (A-B-C-B-A)
         void AddStop(const Stop& stop);
         void AddBus(const Bus& bus);
 
@@ -33,10 +128,26 @@ namespace transport_catalogue {
         const Stop* FindStop(const std::string_view& stop_name) const;
         const Bus* FindBus(std::string_view bus_name) const;
 
-        void SetDistance(const Stop* from, const Stop* to, int distance); // Запись дистанции между остановками в каталог
-        int GetRealDistance(const Stop* from, const Stop* to) const; // Получение фактического расстояния между остановками
+        // Доступ к остановке / маршруту по номеру
+        const Stop* GetStop(StopId id) const;
+        const Bus* GetBus(BusId id) const;
 
-        std::optional<BusInfo> GetBusInfo(const Bus* bus) const; // Получение данных о маршруте
+        // Координаты всех остановок подряд, индекс - номер остановки
+        const std::vector<geo::Coordinates>& GetStopCoordinates() const;
+
+        // Изменение существующих остановки / маршрута. Статистика затронутых маршрутов пересчитывается,
+        // индексы (BuildSpatialIndex, BuildNameIndexes) нужно построить заново, если изменились
+        // их данные (GetChanges).
+        // Остановки маршрута перечисляются полностью, как в AddBus. Копии каталога, сделанные до изменения,
+        // не меняются: названия в них ссылаются на общие с копией блоки хранилища названий
+        void UpdateStop(StopId id, const geo::Coordinates& coordinates);
+        void UpdateBus(BusId id, std::vector<StopId> stops, bool is_round_route);
+
+        // Запись дистанции между остановками в каталог; статистика уже добавленных маршрутов пересчитывается
+        void SetDistance(StopId from, StopId to, int distance);
+        int GetRealDistance(StopId from, StopId to) const; // Получение фактического расстояния между остановками
+
+        std::optional<BusInfo> GetBusInfo(const Bus* bus) const; // Получение данных о маршруте (без пересчёта)
         std::optional<StopInfo> GetStopInfo(const std::string_view& stop_name) const; // Получение данных об остановке
         std::map<std::string_view, const Bus*> GetRouteNames() const; // Получение всех маршрутов из каталога
         std::unordered_map<std::string_view, const Stop*> GetStopNames() const; // Получение всех остановок из каталога
@@ -46,16 +157,53 @@ namespace transport_catalogue {
 
         const RealDistanceTable& GetAllDistances() const;
 
+        // Части, изменённые в этой копии или в original после копирования одного из другого.
+        // Изменение считается по доступу на запись, даже если значение осталось прежним
+        Changes GetChanges(const TransportCatalogue& original) const;
+
+        // Пространственный индекс остановок: строится после добавления всех остановок
+        // или восстанавливается из базы по сохранённому порядку
+        void BuildSpatialIndex();
+        void SetSpatialIndex(std::vector<StopId> order);
+        const SpatialIndex& GetSpatialIndex() const;
+
+        // Совершенные хэш-функции названий остановок и маршрутов: строятся после добавления всех данных.
+        // При загрузке из базы устанавливаются до добавления остановок и маршрутов, поэтому
+        // хэш-таблицы названий при загрузке не строятся
+        void BuildNameIndexes();
+        void SetNameIndexes(NameArena::PerfectHash stop_names, NameArena::PerfectHash bus_names);
+        const NameArena::PerfectHash& GetStopNameIndex() const;
+        const NameArena::PerfectHash& GetBusNameIndex() const;
+
+        // Не более count ближайших к точке остановок в радиусе max_distance метров, по возрастанию расстояния
+        std::vector<NearbyStop> FindNearestStops(const geo::Coordinates& point, size_t count,
+                                                 double max_distance) const;
+
         // Тесты
         void TestGetStopNames();
         void TestGetBusNames();
         void TestGetDistancesBetweenStops();
 
     private:
-        std::deque<Stop> stops_;  //Хранилище остановок
-        std::deque<Bus> buses_;  // Хранилище маршрутов
-        std::unordered_map<std::string_view, const Stop*> stop_names_; // Таблица названий остановок и указателей на данные о них
-        std::map<std::string_view, const Bus*> route_names_; // Таблица названий маршрутов и указателей на данные о них
-        RealDistanceTable real_distances_; // Хэш-таблица фактических расстояний между остановками
+        BusInfo ComputeBusInfo(const Bus* bus) const; // Расчёт статистики маршрута
+        geo::Coordinates PrepareCoordinates(const geo::Coordinates& coordinates) const; // Округление по настройкам
+        void UpdateBusInfos(StopId stop); // Пересчёт статистики маршрутов через остановку
+        void AddStopBus(StopId stop, std::string_view bus_name);
+
+        // Части хранятся раздельно, чтобы изменение одной не копировало остальные.
+        // Ссылки между частями - только номера и представления названий из хранилищ названий
+        GeoSettings geo_settings_;
+        detail::CopyOnWrite<std::deque<Stop>> stops_;  //Хранилище остановок
+        detail::CopyOnWrite<std::deque<Bus>> buses_;  // Хранилище маршрутов
+        detail::CopyOnWrite<std::vector<geo::Coordinates>> stop_coordinates_; // Координаты остановок по номерам
+        detail::CopyOnWrite<geo::PreparedPoints> stop_points_; // Остановки для пакетного расчёта расстояний по номерам
+        detail::CopyOnWrite<NameArena> stop_names_; // Названия остановок и их номера
+        detail::CopyOnWrite<NameArena> bus_names_; // Названия маршрутов и их номера
+        detail::CopyOnWrite<std::map<std::string_view, BusId>> route_names_; // Маршруты, упорядоченные по названию
+        detail::CopyOnWrite<RealDistanceTable> real_distances_; // Фактические расстояния между остановками
+        detail::CopyOnWrite<SpatialIndex> spatial_index_; // Пространственный индекс остановок
+        // Маршруты через остановку по её номеру, по названию
+        detail::CopyOnWrite<std::vector<std::vector<std::string_view>>> stop_buses_;
+        detail::CopyOnWrite<std::vector<BusInfo>> bus_infos_; // Статистика маршрутов по номерам, считается в AddBus
     };
 }
\ No newline at end of file
@@ -1,5 +1,11 @@
+#define _USE_MATH_DEFINES
 #include "transport_router.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
 namespace transport_router {
     TransportRouter::TransportRouter(const transport_catalogue::TransportCatalogue &catalogue)
             : catalogue_(catalogue) {
@@ -11,20 +17,184 @@ namespace transport_router {
     }
 
     void TransportRouter::BuildGraph() {
-        graph_ = std::make_unique<graph::DirectedWeightedGraph<double>>(catalogue_.GetStopsCount() * 2);
+        const bool is_line_model = r_settings_.graph_model == GraphModel::LINE_VERTICES;
+        graph_ = std::make_unique<Graph>(catalogue_.GetStopsCount() * 2 + (is_line_model ? CountLineVertexes() : 0));
+        edges_.clear();
+        profile_router_.reset();
+        profile_items_.clear();
         AddVertexesAndWaitEdges();
-        AddRouteEdges();
-        router_ = std::make_unique<graph::Router<double>>(*graph_);
+        if (is_line_model) {
+            AddLines();
+        } else {
+            AddRouteEdges();
+        }
+        router_ = CreateRouter();
+    }
+
+    void TransportRouter::UpdateSettings(const RouteSettings& r_settings) {
+        if (!graph_ || r_settings.graph_model != r_settings_.graph_model) {
+            SetSettingsAndBuildGraph(r_settings);
+            return;
+        }
+        r_settings_ = r_settings;
+        for (auto& [edge_id, item] : edges_) {
+            item.time = ComputeItemTime(item, r_settings_);
+            graph_->SetEdgeWeight(edge_id, item.time);
+        }
+        router_ = CreateRouter();
+    }
+
+    void TransportRouter::UpdateSettingsFrom(const TransportRouter& other, const RouteSettings& r_settings) {
+        r_settings_ = other.r_settings_;
+        graph_ = other.graph_ ? std::make_unique<Graph>(*other.graph_) : nullptr;
+        edges_ = other.edges_;
+        profile_router_.reset();
+        profile_items_.clear();
+        UpdateSettings(r_settings);
+    }
+
+    std::unique_ptr<graph::BaseRouter<double>> TransportRouter::CreateRouter() const {
+        switch (r_settings_.router_type) {
+            case RouterType::DIJKSTRA:
+                return std::make_unique<graph::DijkstraRouter<double>>(*graph_);
+            case RouterType::CONTRACTION_HIERARCHY:
+                return std::make_unique<graph::ContractionHierarchyRouter<double>>(*graph_);
+            case RouterType::ASTAR:
+                return std::make_unique<graph::AStarRouter<double>>(*graph_, CreateLowerBound());
+            case RouterType::ALL_PAIRS_COMPACT:
+                return std::make_unique<CompactAllPairsRouter>(*graph_);
+            case RouterType::ALL_PAIRS:
+            default:
+                return std::make_unique<graph::Router<double>>(*graph_);
+        }
+    }
+
+    graph::AStarRouter<double>::LowerBound TransportRouter::CreateLowerBound() const {
+        // Остановки как точки в пространстве (в метрах): длина хорды между ними не больше расстояния
+        // по поверхности из geo::ComputeDistance, вычисляется без тригонометрии и удовлетворяет
+        // неравенству треугольника, поэтому оценка на её основе согласованная
+        struct Point {
+            double x = 0.;
+            double y = 0.;
+            double z = 0.;
+        };
+        static const double dr = M_PI / 180.;
+        static const double earth_radius = 6371000.;
+        std::vector<Point> vertex_points(graph_->GetVertexCount());
+        const auto& stop_coordinates = catalogue_.GetStopCoordinates();
+        for (StopId stop = 0; stop < stop_coordinates.size(); ++stop) {
+            const double lat = stop_coordinates[stop].lat * dr;
+            const double lng = stop_coordinates[stop].lng * dr;
+            const Point point = {earth_radius * std::cos(lat) * std::cos(lng),
+                                 earth_radius * std::cos(lat) * std::sin(lng),
+                                 earth_radius * std::sin(lat)};
+            vertex_points[GetStopVertexID(stop)] = point;
+            vertex_points[GetStartVertexID(stop)] = point;
+        }
+        // Вершины линий модели LINE_VERTICES расположены там же, где остановки, на которых в них садятся
+        // или из них выходят
+        for (const auto& [edge_id, item] : edges_) {
+            const auto& edge = graph_->GetEdge(edge_id);
+            if (item.type == ItemType::BOARD) {
+                vertex_points[edge.to] = vertex_points[edge.from];
+            } else if (item.type == ItemType::ALIGHT) {
+                vertex_points[edge.from] = vertex_points[edge.to];
+            }
+        }
+        auto chord = [](const Point& from, const Point& to) {
+            return std::sqrt((from.x - to.x) * (from.x - to.x) + (from.y - to.y) * (from.y - to.y)
+                             + (from.z - to.z) * (from.z - to.z));
+        };
+        // Минимальное время проезда одного метра по прямой. Если дороги не короче расстояния
+        // по прямой, это не меньше 1 / velocity, но реальные расстояния в базе могут быть и короче,
+        // поэтому коэффициент берётся минимальным по всем рёбрам автобусов - так оценка остаётся допустимой
+        double minutes_per_meter = std::numeric_limits<double>::max();
+        for (graph::EdgeId edge_id = 0; edge_id < graph_->GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph_->GetEdge(edge_id);
+            const double distance = chord(vertex_points[edge.from], vertex_points[edge.to]);
+            if (distance > 0) {
+                minutes_per_meter = std::min(minutes_per_meter, edge.weight / distance);
+            }
+        }
+        if (minutes_per_meter == std::numeric_limits<double>::max()) {
+            minutes_per_meter = 0.;
+        }
+        // Запас на погрешность вычислений
+        minutes_per_meter *= 1. - 1e-9;
+        return [vertex_points = std::move(vertex_points), minutes_per_meter, chord](graph::VertexId from,
+                                                                                    graph::VertexId to) {
+            return chord(vertex_points[from], vertex_points[to]) * minutes_per_meter;
+        };
     }
 
     std::optional<TransportRouter::RouteInfo> TransportRouter::GetRouteInfo(const Stop *from, const Stop *to) const {
+        return MakeRouteInfo(router_->BuildRoute(GetStopVertexID(from->id), GetStopVertexID(to->id)), r_settings_);
+    }
+
+    std::optional<TransportRouter::RouteInfo> TransportRouter::GetRouteInfo(const Stop* from, const Stop* to,
+                                                                            const RouteSettings& profile) const {
+        if (profile.velocity == r_settings_.velocity && profile.wait_time == r_settings_.wait_time) {
+            return GetRouteInfo(from, to);
+        }
+        if (!(profile.velocity > 0) || profile.wait_time < 0) {
+            throw std::invalid_argument("Bus velocity should be positive and wait time non-negative");
+        }
+        const graph::DijkstraRouter<double>& profile_router = GetProfileRouter();
+        RouteSettings r_settings = r_settings_;
+        r_settings.velocity = profile.velocity;
+        r_settings.wait_time = profile.wait_time;
+        auto router_info = profile_router.BuildRoute(
+                GetStopVertexID(from->id), GetStopVertexID(to->id), [this, &r_settings](graph::EdgeId edge_id) {
+                    return ComputeItemTime(*profile_items_[edge_id], r_settings);
+                });
+        return MakeRouteInfo(router_info, r_settings);
+    }
+
+    const graph::DijkstraRouter<double>& TransportRouter::GetProfileRouter() const {
+        std::lock_guard guard(profile_mutex_);
+        if (!profile_router_) {
+            profile_items_.resize(graph_->GetEdgeCount());
+            for (const auto& [edge_id, item] : edges_) {
+                profile_items_[edge_id] = &item;
+            }
+            profile_router_ = std::make_unique<graph::DijkstraRouter<double>>(*graph_);
+        }
+        return *profile_router_;
+    }
+
+    std::optional<TransportRouter::RouteInfo> TransportRouter::MakeRouteInfo(
+            const std::optional<graph::BaseRouter<double>::RouteInfo>& router_info,
+            const RouteSettings& r_settings) const {
         RouteInfo route_info;
-        std::optional<graph::Router<double>::RouteInfo> router_info = router_->BuildRoute(GetStopVertexID(from),
-                                                                                          GetStopVertexID(to));
         if (router_info) {
             route_info.time = router_info->weight;
             for (const auto& edge : router_info->edges) {
-                route_info.items.push_back(edges_.at(edge));
+                const Item& item = edges_.at(edge);
+                switch (item.type) {
+                    case ItemType::BOARD:
+                        route_info.items.push_back({ItemType::BUS, item.route_name, 0., 0});
+                        break;
+                    case ItemType::RIDE: {
+                        // Время считается по суммарной длине, как у рёбер модели SPAN_EDGES
+                        Item& bus_item = route_info.items.back();
+                        bus_item.length += item.length;
+                        ++bus_item.span_count;
+                        bus_item.time = ComputeItemTime(bus_item, r_settings);
+                        break;
+                    }
+                    case ItemType::ALIGHT:
+                        break;
+                    default:
+                        route_info.items.push_back(item);
+                        route_info.items.back().time = ComputeItemTime(item, r_settings);
+                }
+            }
+            if (r_settings_.graph_model == GraphModel::LINE_VERTICES) {
+                // Время складывается из элементов ответа так же, как в модели SPAN_EDGES
+                route_info.time = 0.;
+                for (const auto& item : route_info.items) {
+                    route_info.time += item.time;
+                }
             }
             return route_info;
         } else {
@@ -32,39 +202,82 @@ namespace transport_router {
         }
     }
 
+    TransportRouter::TimeMatrix TransportRouter::GetTimeMatrix(const std::vector<const Stop*>& from,
+                                                               const std::vector<const Stop*>& to) const {
+        std::vector<graph::VertexId> sources;
+        sources.reserve(from.size());
+        for (const Stop* stop : from) {
+            sources.push_back(GetStopVertexID(stop->id));
+        }
+        std::vector<graph::VertexId> targets;
+        targets.reserve(to.size());
+        for (const Stop* stop : to) {
+            targets.push_back(GetStopVertexID(stop->id));
+        }
+        return GetProfileRouter().ComputeWeightMatrix(sources, targets);
+    }
+
     TransportRouter::RouteSettings TransportRouter::GetSettings() const {
         return r_settings_;
     }
 
-    graph::VertexId transport_router::TransportRouter::GetStopVertexID(const Stop *from) const {
-        return vertexes_.at(from).first;
+    const TransportRouter::Graph& TransportRouter::GetGraph() const {
+        return *graph_;
+    }
+
+    const TransportRouter::EdgeItems& TransportRouter::GetEdgeItems() const {
+        return edges_;
+    }
+
+    const graph::BaseRouter<double>& TransportRouter::GetRouter() const {
+        return *router_;
+    }
+
+    void TransportRouter::SetPrecomputedRouter(const RouteSettings& r_settings, std::unique_ptr<Graph> graph,
+                                               EdgeItems edges,
+                                               std::unique_ptr<graph::BaseRouter<double>> router) {
+        r_settings_ = r_settings;
+        graph_ = std::move(graph);
+        edges_ = std::move(edges);
+        profile_router_.reset();
+        profile_items_.clear();
+        router_ = router ? std::move(router) : CreateRouter();
+    }
+
+    graph::VertexId TransportRouter::GetStopVertexID(StopId stop) {
+        return static_cast<graph::VertexId>(stop) * 2;
     }
 
-    graph::VertexId transport_router::TransportRouter::GetStartVertexID(const Stop *to) const {
-        return vertexes_.at(to).second;
+    graph::VertexId TransportRouter::GetStartVertexID(StopId stop) {
+        return static_cast<graph::VertexId>(stop) * 2 + 1;
+    }
+
+    double TransportRouter::ComputeItemTime(const Item& item, const RouteSettings& r_settings) {
+        switch (item.type) {
+            case ItemType::WAIT:
+                return static_cast<double>(r_settings.wait_time);
+            case ItemType::BUS:
+            case ItemType::RIDE:
+                return item.length / (r_settings.velocity * 1000 / 60);
+            default:
+                return 0.;
+        }
+    }
+
+    void TransportRouter::AddItemEdge(graph::VertexId from, graph::VertexId to, Item item) {
+        item.time = ComputeItemTime(item, r_settings_);
+        edges_[graph_->AddEdge({from, to, item.time})] = item;
     }
 
     void TransportRouter::CreateRouteEdge(graph::VertexId from, graph::VertexId to, const std::string_view bus_name,
                                           double length, int span_count) {
-        const double route_time = length / (r_settings_.velocity * 1000 / 60);
-        graph::Edge<double> edge = {from, to, route_time};
-        edges_[graph_->AddEdge(edge)] = {ItemType::BUS,
-                                         bus_name,
-                                         route_time,
-                                         span_count};
+        AddItemEdge(from, to, {ItemType::BUS, bus_name, 0., span_count, length});
     }
 
     void TransportRouter::AddVertexesAndWaitEdges() {
-        graph::VertexId vertex_id = 0;
-        const auto wait_time = static_cast<double>(r_settings_.wait_time);
-        for (const auto& [stop_name, stop_ptr] : catalogue_.GetStopNames()) {
-            vertexes_[stop_ptr] = {vertex_id, vertex_id + 1};
-            graph::Edge<double> edge = {vertex_id, vertex_id + 1, wait_time};
-            edges_[graph_->AddEdge(edge)] = {ItemType::WAIT,
-                                             stop_name,
-                                             wait_time,
-                                             1};
-            vertex_id += 2;
+        for (StopId stop = 0; stop < catalogue_.GetStopsCount(); ++stop) {
+            AddItemEdge(GetStopVertexID(stop), GetStartVertexID(stop),
+                        {ItemType::WAIT, catalogue_.GetStop(stop)->name, 0., 1});
         }
     }
 
@@ -111,4 +324,49 @@ namespace transport_router {
             }
         }
     }
+
+    size_t TransportRouter::CountLineVertexes() const {
+        size_t count = 0;
+        for (const auto& [bus_name, bus_ptr] : catalogue_.GetRouteNames()) {
+            if (bus_ptr->stops.empty()) {
+                continue;
+            }
+            // Некольцевой маршрут делится посередине на две линии, средняя остановка входит в обе
+            count += bus_ptr->stops.size() + (bus_ptr->is_round_route ? 0 : 1);
+        }
+        return count;
+    }
+
+    void TransportRouter::AddLine(const std::string_view bus_name, const Bus* bus_ptr, size_t begin, size_t end,
+                                  graph::VertexId& vertex_id) {
+        for (size_t i = begin; i < end; ++i, ++vertex_id) {
+            const StopId stop = bus_ptr->stops[i];
+            if (i + 1 < end) {
+                AddItemEdge(GetStartVertexID(stop), vertex_id, {ItemType::BOARD, bus_name, 0., 0});
+                const auto length = static_cast<double>(catalogue_.GetRealDistance(stop, bus_ptr->stops[i + 1]));
+                AddItemEdge(vertex_id, vertex_id + 1, {ItemType::RIDE, bus_name, 0., 1, length});
+            }
+            if (i > begin) {
+                AddItemEdge(vertex_id, GetStopVertexID(stop), {ItemType::ALIGHT, bus_name, 0., 0});
+            }
+        }
+    }
+
+    void TransportRouter::AddLines() {
+        graph::VertexId vertex_id = catalogue_.GetStopsCount() * 2;
+        for (const auto& [bus_name, bus_ptr] : catalogue_.GetRouteNames()) {
+            const size_t stops_count = bus_ptr->stops.size();
+            if (stops_count == 0) {
+                continue;
+            }
+            if (bus_ptr->is_round_route) {
+                AddLine(bus_name, bus_ptr, 0, stops_count, vertex_id);
+            } else {
+                // Остановки некольцевого маршрута хранятся вместе с обратным направлением
+                const size_t middle = stops_count / 2;
+                AddLine(bus_name, bus_ptr, 0, middle + 1, vertex_id);
+                AddLine(bus_name, bus_ptr, middle, stops_count, vertex_id);
+            }
+        }
+    }
 }
\ No newline at end of file
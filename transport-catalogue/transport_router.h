@@ -1,23 +1,52 @@
 #pragma once
 #include <string_view>
 #include <memory>
+#include <mutex>
 #include <iostream>
 
 #include "transport_catalogue.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "astar_router.h"
 
 namespace transport_router {
 
     class TransportRouter {
     public:
+        // Движок поиска кратчайших путей
+        enum class RouterType {
+            ALL_PAIRS, // предрасчёт всех пар вершин: быстрые запросы, O(V^3) времени и O(V^2) памяти на старте
+            DIJKSTRA,  // поиск на каждый запрос: линейный старт, подходит для больших графов
+            CONTRACTION_HIERARCHY, // иерархия сжатия: умеренный предрасчёт и память, очень быстрые запросы
+            ALL_PAIRS_COMPACT, // как ALL_PAIRS, но таблицы хранят float-веса и 32-битные рёбра: вдвое меньше памяти
+            ASTAR // двунаправленный A* по координатам остановок: без предрасчёта, поиск идёт в сторону цели
+        };
+
+        // Модель графа маршрутов
+        enum class GraphModel {
+            SPAN_EDGES, // ребро на каждую пару остановок маршрута: O(n^2) рёбер на маршрут
+            LINE_VERTICES // вершина на каждую позицию маршрута и рёбра только между соседними позициями: O(n)
+        };
+
+        // Маршрутизатор всех пар вершин с компактными таблицами
+        using CompactAllPairsRouter = graph::Router<double, float, uint32_t>;
+
         struct RouteSettings {
             int wait_time; // время ожидания на остановке
             double velocity; // скорость автобуса
+            RouterType router_type = RouterType::ALL_PAIRS; // движок маршрутизатора
+            GraphModel graph_model = GraphModel::SPAN_EDGES; // модель графа
         };
 
         enum class ItemType {
             WAIT,
-            BUS
+            BUS,
+            // Служебные рёбра модели LINE_VERTICES: посадка, проезд одного перегона и высадка.
+            // В ответе последовательность посадка-проезды-высадка превращается в один элемент BUS
+            BOARD,
+            RIDE,
+            ALIGHT
         };
 
         struct Item {
@@ -25,6 +54,7 @@ namespace transport_router {
             std::string_view route_name;
             double time;
             int span_count;
+            double length = 0.; // длина пути автобуса по ребру (BUS и RIDE); время пересчитывается из неё
         };
 
         struct RouteInfo {
@@ -32,6 +62,13 @@ namespace transport_router {
             std::vector<Item> items;
         };
 
+        // Время в пути между остановками: строка на каждую остановку отправления,
+        // std::nullopt, если остановка назначения недостижима
+        using TimeMatrix = graph::WeightMatrix<double>;
+
+        using Graph = graph::DirectedWeightedGraph<double>;
+        using EdgeItems = std::map<graph::EdgeId, Item>;
+
         TransportRouter(const transport_catalogue::TransportCatalogue& catalogue);
 
         // Устанавливаем настройки маршрутизатора
@@ -40,16 +77,63 @@ namespace transport_router {
         //Строим граф
         void BuildGraph ();
 
+        // Меняем скорость автобусов и время ожидания без перестройки графа: веса рёбер пересчитываются
+        // по сохранённым длинам, заново создаётся только маршрутизатор. Если граф ещё не построен
+        // или модель графа в настройках другая, граф строится заново
+        void UpdateSettings(const RouteSettings& r_settings);
+
+        // Граф маршрутизатора other, построенного по тому же справочнику, с новыми настройками: граф и рёбра
+        // копируются и перевзвешиваются как в UpdateSettings, other не меняется (он может обслуживать запросы)
+        void UpdateSettingsFrom(const TransportRouter& other, const RouteSettings& r_settings);
+
         std::optional<RouteInfo> GetRouteInfo(const Stop* from, const Stop* to) const;
 
+        // Маршрут с собственными скоростью и временем ожидания (модель графа берётся из настроек маршрутизатора).
+        // Если они отличаются от настроек маршрутизатора, веса рёбер вычисляются по длинам во время поиска Дейкстры
+        std::optional<RouteInfo> GetRouteInfo(const Stop* from, const Stop* to, const RouteSettings& profile) const;
+
+        // Матрица времени в пути для всех пар остановок отправления и назначения без восстановления маршрутов
+        TimeMatrix GetTimeMatrix(const std::vector<const Stop*>& from, const std::vector<const Stop*>& to) const;
+
         RouteSettings GetSettings() const;
 
+        // Доступ к построенному графу и маршрутизатору (для сериализации)
+        const Graph& GetGraph() const;
+        const EdgeItems& GetEdgeItems() const;
+        const graph::BaseRouter<double>& GetRouter() const;
+
+        // Восстанавливаем ранее построенные граф и маршрутизатор без повторных расчётов.
+        // Маршрутизатор должен ссылаться на переданный граф; если он не передан,
+        // создаётся маршрутизатор выбранного в настройках типа
+        void SetPrecomputedRouter(const RouteSettings& r_settings, std::unique_ptr<Graph> graph,
+                                  EdgeItems edges,
+                                  std::unique_ptr<graph::BaseRouter<double>> router);
+
     private:
-        // Номер вершины графа (с ожиданием)
-        graph::VertexId GetStopVertexID(const Stop* from) const;
+        // Номер вершины графа (с ожиданием): вершины остановок идут парами в порядке их номеров
+        static graph::VertexId GetStopVertexID(StopId stop);
 
         // Номер вершины графа (без ожидания)
-        graph::VertexId GetStartVertexID(const Stop* to) const;
+        static graph::VertexId GetStartVertexID(StopId stop);
+
+        // Создаём маршрутизатор выбранного в настройках типа
+        std::unique_ptr<graph::BaseRouter<double>> CreateRouter() const;
+
+        // Нижняя оценка времени пути между вершинами графа по расстоянию между остановками
+        graph::AStarRouter<double>::LowerBound CreateLowerBound() const;
+
+        // Маршрутизатор Дейкстры по графу (profile_router_), при необходимости создаётся
+        const graph::DijkstraRouter<double>& GetProfileRouter() const;
+
+        // Время на ребре при заданных настройках
+        static double ComputeItemTime(const Item& item, const RouteSettings& r_settings);
+
+        // Собираем ответ из рёбер найденного пути; время элементов считается по заданным настройкам
+        std::optional<RouteInfo> MakeRouteInfo(const std::optional<graph::BaseRouter<double>::RouteInfo>& router_info,
+                                               const RouteSettings& r_settings) const;
+
+        // Добавляем ребро в граф; вес и время элемента вычисляются по текущим настройкам
+        void AddItemEdge(graph::VertexId from, graph::VertexId to, Item item);
 
         // Добавляем ребра маршрутов в граф
         void CreateRouteEdge(graph::VertexId from, graph::VertexId to, const std::string_view bus_name,
@@ -67,11 +151,27 @@ namespace transport_router {
         //Добавляем ребра маршрутов между остановками
         void AddRouteEdges();
 
+        // Число вершин линий маршрутов в модели LINE_VERTICES
+        size_t CountLineVertexes() const;
+
+        // Добавляем вершины линии для остановок [begin, end) маршрута, рёбра проезда между ними,
+        // рёбра посадки и высадки
+        void AddLine(const std::string_view bus_name, const Bus* bus_ptr, size_t begin, size_t end,
+                     graph::VertexId& vertex_id);
+
+        //Добавляем линии всех маршрутов
+        void AddLines();
+
         const transport_catalogue::TransportCatalogue& catalogue_;
         RouteSettings r_settings_; // Настройки (скорость и время ожидания) маршрута
-        std::unique_ptr<graph::DirectedWeightedGraph<double>> graph_; // Граф
-        std::map<const Stop*, std::pair<int, int>> vertexes_; // Вершины графа
-        std::map<graph::EdgeId, Item> edges_; // Ребра графа
-        std::unique_ptr<graph::Router<double>> router_; // Маршрутизатор
+        std::unique_ptr<Graph> graph_; // Граф
+        EdgeItems edges_; // Ребра графа
+        std::unique_ptr<graph::BaseRouter<double>> router_; // Маршрутизатор
+        // Маршрутизатор Дейкстры по графу для запросов с собственными настройками и матриц времени
+        // и элементы рёбер по номерам; создаются при первом таком запросе (под мьютексом: запросы могут
+        // идти из нескольких потоков), веса рёбер проверяются один раз при создании
+        mutable std::mutex profile_mutex_;
+        mutable std::unique_ptr<graph::DijkstraRouter<double>> profile_router_;
+        mutable std::vector<const Item*> profile_items_;
     };
 } // namespace transport_router
\ No newline at end of file